@@ -10,6 +10,8 @@
  * Uses externally defined functions SUBSTITUTION_SCORE() and GAP_SCORE() to evaluate scores.
  * 
  * Outputs a struct containing output.ZWpair => the aligned words, as a pair of vectors of strings, as well as output.distance => the weighted levenshtein edit distance between strings.
+ *
+ * Internally everything runs on interned PhonemeIds (see phoneme_id.hpp), with PHONEME::GAP marking gaps. The vector<string> overload of hirschberg() converts at the boundary.
  * 
  * 
  * Hirschberg Algorithm for Sequence Alignment
@@ -28,10 +30,16 @@
  */
 
 #include "distance.hpp"
+#include "levenshtein_distance.hpp"
+#include "phoneme_id.hpp"
+#include "task_pool.hpp"
 
+#include <algorithm>
 #include <iostream>
+#include <span>
 #include <vector>
 #include <cstring>
+#include <cstdint>
 #include <cmath>
 
 struct Alignment_And_Distance {
@@ -39,8 +47,20 @@ struct Alignment_And_Distance {
    int distance{};
 };
 
-//Useful tools
-inline int min3(int a, int b, int c);
+// Alignment of PhonemeIds, gaps are PHONEME::GAP.
+using PhonemeAlignment = std::pair<PhonemeSequence, PhonemeSequence>;
+
+struct Phoneme_Alignment_And_Distance {
+   PhonemeAlignment ZWpair{};
+   int distance{};
+};
+
+// Alignment from a banded DP, optimal is whether no alignment outside the band could cost less
+struct Banded_Alignment_And_Distance {
+   PhonemeAlignment ZWpair{};
+   int distance{};
+   bool optimal{};
+};
 
 // Prints out the ZWpair that we get back from hirschberg
 inline void print_pair(std::pair< std::vector<std::string>, std::vector<std::string> > ZWpair ) {
@@ -60,318 +80,584 @@ inline void print_pair(std::pair< std::vector<std::string>, std::vector<std::str
     std::cout << std::endl;
 }
 
-//overload pair sum
-inline std::pair<std::vector<std::string>, std::vector<std::string>> operator+(std::pair<std::vector<std::string>, std::vector<std::string>> const& one, std::pair<std::vector<std::string>, std::vector<std::string>> const& two);
+// Converts an alignment of PhonemeIds back to ARPABET strings, with "-" for gaps
+inline Alignment_And_Distance to_alignment_and_distance(const Phoneme_Alignment_And_Distance& alignment) {
+    Alignment_And_Distance alignment_and_distance{};
+    alignment_and_distance.ZWpair.first = ids_to_phones(alignment.ZWpair.first);
+    alignment_and_distance.ZWpair.second = ids_to_phones(alignment.ZWpair.second);
+    alignment_and_distance.distance = alignment.distance;
+    return alignment_and_distance;
+}
+
+/**
+ * Compact form of an alignment: runs of edit operations, each pointing at the phonemes it covers, instead of two padded columns of strings.
+ *
+ * A run covers length phonemes of X starting at x_begin and/or of Y starting at y_begin. Match and Substitute runs consume both, Delete only X (X against gaps), Insert only Y (gaps against Y). Alignments of similar sequences are mostly long Match runs, so a script is usually a handful of runs however long the texts.
+ *
+ * It keeps the two sequences it indexes, so the ZWpair of strings can be rebuilt from it alone, when (and if) something needs to print it. See to_alignment_and_distance().
+*/
+enum class EditOp : std::uint8_t {
+    Match,
+    Substitute,
+    Insert,
+    Delete
+};
+
+struct EditRun {
+   std::uint32_t x_begin{};
+   std::uint32_t y_begin{};
+   std::uint32_t length{};
+   EditOp op{};
+
+   friend bool operator==(const EditRun&, const EditRun&) = default;
+};
+
+struct Edit_Script_And_Distance {
+   PhonemeSequence X{};
+   PhonemeSequence Y{};
+   std::vector<EditRun> runs{};
+   int distance{};
+};
+
+/**
+ * Run-length encodes an alignment of PhonemeIds.
+ *
+ * @param ZWpair (PhonemeAlignment): aligned columns, gaps are PHONEME::GAP
+ * @return (vector<EditRun>): the columns as runs, in order, merging neighbouring columns with the same operation
+*/
+inline std::vector<EditRun> to_edit_runs(const PhonemeAlignment& ZWpair) {
+    std::vector<EditRun> runs{};
+    std::uint32_t x{};
+    std::uint32_t y{};
+    for (std::size_t k{}; k < ZWpair.first.size(); ++k) {
+        const PhonemeId a = ZWpair.first[k];
+        const PhonemeId b = ZWpair.second[k];
+        const EditOp op = a == PHONEME::GAP ? EditOp::Insert
+                        : b == PHONEME::GAP ? EditOp::Delete
+                        : a == b ? EditOp::Match : EditOp::Substitute;
+        if (!runs.empty() && runs.back().op == op) {
+            ++runs.back().length;
+        }
+        else {
+            runs.push_back(EditRun{x, y, 1, op});
+        }
+        x += op != EditOp::Insert;
+        y += op != EditOp::Delete;
+    }
+    return runs;
+}
+
+// Edit script of alignment, an alignment of X with Y
+inline Edit_Script_And_Distance to_edit_script(std::span<const PhonemeId> X, std::span<const PhonemeId> Y, const Phoneme_Alignment_And_Distance& alignment) {
+    return Edit_Script_And_Distance{PhonemeSequence(X.begin(), X.end()), PhonemeSequence(Y.begin(), Y.end()), to_edit_runs(alignment.ZWpair), alignment.distance};
+}
 
-//sum_vectors: sum vector function
-inline std::vector <int> sum_vectors(const std::vector<int>& v1, const std::vector<int>& v2);
+// Expands an edit script back into aligned columns of PhonemeIds
+inline PhonemeAlignment to_phoneme_alignment(const Edit_Script_And_Distance& script) {
+    PhonemeAlignment ZWpair{};
+    for (const EditRun& run : script.runs) {
+        for (std::uint32_t k{}; k < run.length; ++k) {
+            ZWpair.first.push_back(run.op == EditOp::Insert ? PHONEME::GAP : script.X[run.x_begin + k]);
+            ZWpair.second.push_back(run.op == EditOp::Delete ? PHONEME::GAP : script.Y[run.y_begin + k]);
+        }
+    }
+    return ZWpair;
+}
+
+// Converts an edit script to ARPABET strings, with "-" for gaps
+inline Alignment_And_Distance to_alignment_and_distance(const Edit_Script_And_Distance& script) {
+    return to_alignment_and_distance(Phoneme_Alignment_And_Distance{to_phoneme_alignment(script), script.distance});
+}
 
 //NWScore: return last line of score matrix
-inline std::vector<int> NWScore(const std::vector<std::string>& X, const std::vector<std::string>& Y);
+inline std::vector<int> NWScore(std::span<const PhonemeId> X, std::span<const PhonemeId> Y);
+
+//NWScore, bounded: cells over max_distance are DISTANCE_OVER_BOUND, stops early once a whole line is over
+inline std::vector<int> NWScore(std::span<const PhonemeId> X, std::span<const PhonemeId> Y, int max_distance);
 
 //NeedlemanWunsch: returns the alignment pair with standard algorithm
-inline Alignment_And_Distance NeedlemanWunsch(const std::vector<std::string>& X, const std::vector<std::string>& Y);
+inline Phoneme_Alignment_And_Distance NeedlemanWunsch(std::span<const PhonemeId> X, std::span<const PhonemeId> Y);
 
-//argmax_element: returns position of max element in the vector argument
-inline std::size_t argmin_element(const std::vector<int> score);
+//NeedlemanWunschAppend: appends the alignment of X and Y to ZWpair, with the gap penalties given rather than recomputed, returns the distance
+inline int NeedlemanWunschAppend(std::span<const PhonemeId> X, std::span<const PhonemeId> Y,
+                                 std::span<const int> gaps_x, std::span<const int> gaps_y, PhonemeAlignment& ZWpair);
 
+//end_rhyme_alignment: alignment of two whole line ends anchored at their ends, leading material free, see end_rhyme_distance()
+inline Phoneme_Alignment_And_Distance end_rhyme_alignment(std::span<const PhonemeId> X, std::span<const PhonemeId> Y);
+
+//Which neighbour a cell of the NeedlemanWunsch matrix got its score from, stored in 2 bits
+enum class Traceback : std::uint8_t {
+    Diagonal,   // substitution (or match) of X[i-1] and Y[j-1]
+    Up,         // X[i-1] against a gap
+    Left        // a gap against Y[j-1]
+};
 
+//hirschberg hands subproblems of at most this many cells to NeedlemanWunsch rather than splitting them further.
+//Measured: the splits' row fills use the SIMD kernels and the full matrix doesn't, so this stays small (a 32x32 matrix), and only cuts the tail of the recursion.
+inline constexpr std::size_t HIRSCHBERG_FULL_NW_CELLS{1024};
+
+//hirschberg_banded: alignment through the cells within band diagonals of the corner to corner diagonal only, see levenshtein_distance_banded()
+inline Banded_Alignment_And_Distance hirschberg_banded(std::span<const PhonemeId> X, std::span<const PhonemeId> Y, std::size_t band);
+
+//Given a Task_Pool, hirschberg runs the two score passes of a level, and then its two halves, side by side while the level has at least this many cells.
+//Forking costs a few microseconds, about what the SIMD fills take for this many cells.
+inline constexpr std::size_t HIRSCHBERG_PARALLEL_CELLS{1 << 16};
 
 //hirschberg: main algorithm; returns alignments-pair space-efficiently
+inline Phoneme_Alignment_And_Distance hirschberg(std::span<const PhonemeId> X, std::span<const PhonemeId> Y);
+
+//hirschberg, bounded: empty alignment and DISTANCE_OVER_BOUND if the distance is over max_distance
+inline Phoneme_Alignment_And_Distance hirschberg(std::span<const PhonemeId> X, std::span<const PhonemeId> Y, int max_distance);
+
+//hirschberg, bounded, spreading long alignments over pool's threads (DISTANCE_OVER_BOUND for no bound). Same result as without the pool.
+inline Phoneme_Alignment_And_Distance hirschberg(std::span<const PhonemeId> X, std::span<const PhonemeId> Y, int max_distance, Task_Pool& pool);
+
 // Feed it two vectors of strings of ARPABET phones.
 // TODO standardize this to use space-separated strings so that it aligns with CMUdict
 inline Alignment_And_Distance hirschberg(const std::vector<std::string>& X, const std::vector<std::string>& Y);
 
 //Functions
-//Return minimum of three integers
-int min3(int a, int b, int c)
+std::vector<int> NWScore(std::span<const PhonemeId> X, std::span<const PhonemeId> Y)
 {
-    if (a <= b && a <= c) return a;
-    else if (b <= a && b <= c) return b;
-    else return c;
+    // Same fill as levenshtein_distance(), so long sequences get the SIMD kernels too
+    std::vector<int> Lastline(Y.size() + 1, 0);
+    levenshtein_last_row(X, Y, gap_penalties(X), gap_penalties(Y), phoneme_cost_table(), Lastline);
+    return Lastline;
 }
 
-std::vector<int> NWScore(const std::vector<std::string>& X, const std::vector<std::string>& Y)
+std::vector<int> NWScore(std::span<const PhonemeId> X, std::span<const PhonemeId> Y, int max_distance)
 {
-    const int n = X.size();
-    const int m = Y.size();
-    std::vector<std::vector<int>> Score(n+1, std::vector<int>(m+1, 0));
-    std::vector<int> Lastline;
-    
-    //Step 1: start from zero
-    Score[0][0]=0;
-    
-    //Step 1.1: first row penalties
-    for (int j=1;j<=m;j++)
+    return levenshtein_last_row_bounded(X, Y, gap_penalties(X), gap_penalties(Y), phoneme_cost_table(), max_distance);
+}
+
+Phoneme_Alignment_And_Distance NeedlemanWunsch (std::span<const PhonemeId> X, std::span<const PhonemeId> Y)
+{
+    Phoneme_Alignment_And_Distance alignment_and_distance{};
+    alignment_and_distance.distance = NeedlemanWunschAppend(X, Y, gap_penalties(X), gap_penalties(Y), alignment_and_distance.ZWpair);
+    return alignment_and_distance;
+}
+
+Phoneme_Alignment_And_Distance end_rhyme_alignment(std::span<const PhonemeId> X, std::span<const PhonemeId> Y)
+{
+    // Line ends are short, so the full matrix does; the free leading material shows up as gaps
+    std::vector<int> gaps_x(X.size());
+    std::vector<int> gaps_y(Y.size());
+    end_rhyme_gap_penalties(X, Y, gaps_x, gaps_y);
+    Phoneme_Alignment_And_Distance alignment_and_distance{};
+    alignment_and_distance.distance = NeedlemanWunschAppend(X, Y, gaps_x, gaps_y, alignment_and_distance.ZWpair);
+    return alignment_and_distance;
+}
+
+int NeedlemanWunschAppend (std::span<const PhonemeId> X, std::span<const PhonemeId> Y,
+                           std::span<const int> gaps_x, std::span<const int> gaps_y, PhonemeAlignment& ZWpair)
+{
+    const std::size_t n = X.size(), m = Y.size();
+    const PhonemeCostTable& costs = phoneme_cost_table();
+
+    // Scores only need two rows. Which neighbour each cell came from is kept for the traceback, 2 bits per cell, 32 cells per 64 bit word.
+    // (Words rather than bytes: a store through a byte pointer may alias the rows, and makes the compiler reload them every cell.)
+    struct RowScratch;
+    struct TracebackScratch;
+    const std::span<int> rows{scratch_buffer<int, RowScratch>(2 * (m+1))};
+    const std::size_t row_words = (m+1 + 31) / 32;
+    const std::span<std::uint64_t> traceback{scratch_buffer<std::uint64_t, TracebackScratch>((n+1) * row_words)};
+    const auto get_step = [&](std::size_t i, std::size_t j) {
+        return static_cast<Traceback>((traceback[i * row_words + j / 32] >> (2 * (j % 32))) & 0b11);
+    };
+    int* prev = rows.data();
+    int* curr = rows.data() + m+1;
+
+    //STEP 1: first row, the first column is filled along with each row
+    prev[0] = 0;
+    std::fill(traceback.begin(), traceback.begin() + row_words, 0xAAAA'AAAA'AAAA'AAAAull);    // all Traceback::Left
+    for (std::size_t j=1;j<m+1;j++)
     {
-        Score[0][j] = Score[0][j-1] + GAP_PENALTY(Y[j-1], j > 1 ? Y[j-2] : "");
+        prev[j] = prev[j-1] + gaps_y[j-1];
     }
-   
-    for (int i=1; i<=n;i++)
+
+    //STEP 2: Needelman-Wunsch, ties go to the diagonal, then up
+    for (std::size_t i=1;i<n+1;i++)
     {
-        Score[1][0] = Score[0][0] + GAP_PENALTY(X[i-1], i > 1 ? X[i-2] : "");
-        for (int j=1; j<=m;j++)
+        const int* substitution_row = costs.substitution_row(X[i-1]);
+        const int deletion_cost = gaps_x[i-1];
+        std::uint64_t* steps = traceback.data() + i * row_words;
+        curr[0] = prev[0] + deletion_cost;
+        std::uint64_t packed = static_cast<std::uint64_t>(Traceback::Up);
+        for (std::size_t j=1;j<m+1;j++)
         {
-            Score[1][j] = min3(
-                               Score[1][j-1] + GAP_PENALTY(Y[j-1], j > 1 ? Y[j-2] : ""),
-                               Score[0][j] + GAP_PENALTY(X[i-1], i > 1 ? X[i-2] : ""),
-                               Score[0][j-1] + SUBSTITUTION_SCORE(X[i-1], Y[j-1])
-                               );
+            const int diagonal = prev[j-1] + substitution_row[Y[j-1]];
+            const int up = prev[j] + deletion_cost;
+            const int left = curr[j-1] + gaps_y[j-1];
+            const int best_of_two = std::min(diagonal, up);
+            std::uint64_t step = up < diagonal ? static_cast<std::uint64_t>(Traceback::Up) : static_cast<std::uint64_t>(Traceback::Diagonal);
+            step = left < best_of_two ? static_cast<std::uint64_t>(Traceback::Left) : step;
+            curr[j] = std::min(best_of_two, left);
+
+            packed |= step << (2 * (j % 32));
+            if (j % 32 == 31)
+            {
+                steps[j / 32] = packed;
+                packed = 0;
+            }
         }
-        
-        //useless, da portare sotto!
-        for (int j=0;j<=m;j++)
+        if ((m+1) % 32 != 0)
         {
-            Score[0][j] = Score[1][j];
+            steps[m / 32] = packed;
         }
+        std::swap(prev, curr);
     }
-    
-    for (int j=0;j<=m;j++)
+
+    //STEP 3: Reconstruct alignment, backwards onto the end of ZWpair, then put that stretch in order
+    const std::size_t start = ZWpair.first.size();
+    std::size_t i = n, j = m;
+    while (i>0 || j>0)
     {
-        Lastline.push_back( Score[1][j] );
+        switch (get_step(i, j))
+        {
+            case Traceback::Diagonal:
+                ZWpair.first.push_back(X[--i]);
+                ZWpair.second.push_back(Y[--j]);
+                break;
+            case Traceback::Up:
+                ZWpair.first.push_back(X[--i]);
+                ZWpair.second.push_back(PHONEME::GAP);
+                break;
+            case Traceback::Left:
+                ZWpair.first.push_back(PHONEME::GAP);
+                ZWpair.second.push_back(Y[--j]);
+                break;
+        }
     }
-    
-    return Lastline;
-    
-}
+    std::reverse(ZWpair.first.begin() + start, ZWpair.first.end());
+    std::reverse(ZWpair.second.begin() + start, ZWpair.second.end());
 
-Alignment_And_Distance NeedlemanWunsch (const std::vector<std::string>& X, const std::vector<std::string>& Y)
-{
-    Alignment_And_Distance alignment_and_distance{};
+    return prev[m];
+}
 
-    const int n = X.size(), m = Y.size();
 
-    std::vector<std::vector<int>> M(n+1, std::vector<int>(m+1, 0));
-    // int M[n+1][m+1];
-    //STEP 1: assign first row and column
-    M[0][0] = 0;
-    for (int i=1;i<n+1;i++)
-    {
-        M[i][0] = M[i-1][0] + GAP_PENALTY(X[i-1], i > 1 ? X[i-2] : "");
-    }
-    for (int i=1;i<m+1;i++)
-    {
-        M[0][i] = M[0][i-1] + GAP_PENALTY(Y[i-1], i > 1 ? Y[i-2] : "");
-    }
-    
-    //STEP 2: Needelman-Wunsch
-    for (int i=1;i<n+1;i++)
+/**
+ * State shared by every level of one hirschberg() call.
+ *
+ * Subproblems are ranges [x_begin, x_end) of X and [y_begin, y_end) of Y, never copies. The backward pass needs them reversed, and the reverse of X[a, b) is X_rev[n-b, n-a), so X and Y are reversed once up front, along with their gap penalties.
+ *
+ * Gap penalties are those of the whole sequences, so a range that starts after a repeated consonant still gets its discount, and the two halves' scores add up to exactly what levenshtein_distance() computes for the whole.
+ *
+ * The two score lines are only needed until a level has picked its split, so every level takes them from the scratch of the thread it runs on, and reuses them. The alignment is appended in order, left half before right half.
+ *
+ * With a pool, big levels run their two halves as tasks (see HIRSCHBERG_PARALLEL_CELLS). The left half appends to its parent's output as usual, the right half to its own, which is appended once both are done. Everything here is only read by then, so the tasks share the workspace.
+*/
+struct Hirschberg_Workspace {
+    std::span<const PhonemeId> X{};
+    std::span<const PhonemeId> Y{};
+    std::span<const PhonemeId> X_rev{};
+    std::span<const PhonemeId> Y_rev{};
+    std::span<const int> gaps_x{};
+    std::span<const int> gaps_y{};
+    std::span<const int> gaps_x_rev{};
+    std::span<const int> gaps_y_rev{};
+    Task_Pool* pool{};
+
+    // Everything lives in per-thread scratch buffers (see scratch_buffer()), so only the first, or longest, alignments on a thread allocate
+    Hirschberg_Workspace(std::span<const PhonemeId> X, std::span<const PhonemeId> Y, Task_Pool* pool = nullptr)
+        : X{X}, Y{Y}, pool{pool}
     {
-        for (int j=1;j<m+1;j++)
-        {
-            M[i][j] = min3(M[i-1][j-1] + SUBSTITUTION_SCORE(X[i-1], Y[j-1]),
-                          M[i][j-1] + GAP_PENALTY(Y[j-1], j > 1 ? Y[j-2] : ""),
-                          M[i-1][j] + GAP_PENALTY(X[i-1], i > 1 ? X[i-2] : ""));
-        }
+        const std::size_t n = X.size(), m = Y.size();
+
+        struct PhonemeScratch;
+        const std::span<PhonemeId> reversed{scratch_buffer<PhonemeId, PhonemeScratch>(n + m)};
+        std::reverse_copy(X.begin(), X.end(), reversed.begin());
+        std::reverse_copy(Y.begin(), Y.end(), reversed.begin() + n);
+        X_rev = reversed.first(n);
+        Y_rev = reversed.subspan(n);
+
+        struct ScoreScratch;
+        const std::span<int> scratch{scratch_buffer<int, ScoreScratch>(2 * (n + m))};
+        const std::span<int> forward_gaps_x{scratch.first(n)};
+        const std::span<int> forward_gaps_y{scratch.subspan(n, m)};
+        const std::span<int> reversed_gaps_x{scratch.subspan(n + m, n)};
+        const std::span<int> reversed_gaps_y{scratch.subspan(2 * n + m, m)};
+        gap_penalties(X, forward_gaps_x);
+        gap_penalties(Y, forward_gaps_y);
+        std::reverse_copy(forward_gaps_x.begin(), forward_gaps_x.end(), reversed_gaps_x.begin());
+        std::reverse_copy(forward_gaps_y.begin(), forward_gaps_y.end(), reversed_gaps_y.begin());
+        gaps_x = forward_gaps_x;
+        gaps_y = forward_gaps_y;
+        gaps_x_rev = reversed_gaps_x;
+        gaps_y_rev = reversed_gaps_y;
     }
+};
 
-    // Set distance
-    alignment_and_distance.distance = M[n][m];
+/**
+ * One level of hirschberg(): aligns X[x_begin, x_end) with Y[y_begin, y_end), appending to ZWpair.
+ *
+ * @param max_distance (int): only the top level is bounded, DISTANCE_OVER_BOUND below it
+ * @return (int): distance of the ranges, DISTANCE_OVER_BOUND, with nothing appended, if that is over max_distance
+*/
+inline int hirschberg_range(const Hirschberg_Workspace& workspace, PhonemeAlignment& ZWpair, std::size_t x_begin, std::size_t x_end,
+                            std::size_t y_begin, std::size_t y_end, int max_distance = DISTANCE_OVER_BOUND)
+{
+    const std::size_t n = x_end - x_begin;
+    const std::size_t m = y_end - y_begin;
 
-    
-    //STEP 3: Reconstruct alignment
-    std::vector<std::string> A_1{};
-    std::vector<std::string> A_2{};
-    int i = n, j = m;
-    while (i>0 || j>0)
+    // Small enough to align in one go, or nothing left to split
+    if (n <= 1 || m <= 1 || (n+1) * (m+1) <= HIRSCHBERG_FULL_NW_CELLS)
     {
-        if (i>0
-            && j>0
-            && (M[i][j] == M[i-1][j-1] + SUBSTITUTION_SCORE(X[i-1], Y[j-1])))
+        const std::size_t start = ZWpair.first.size();
+        int distance{};
+        if (n==0)
         {
-            A_1.insert(A_1.begin(), X[i-1]);
-            A_2.insert(A_2.begin(), Y[j-1]);
-            i--;
-            j--;
+            for (std::size_t j=y_begin; j<y_end; j++)
+            {
+                ZWpair.first.emplace_back(PHONEME::GAP);
+                ZWpair.second.emplace_back(workspace.Y[j]);
+                distance += workspace.gaps_y[j];
+            }
         }
-
-        else if (i>0
-            && (M[i][j] == M[i-1][j] + GAP_PENALTY(X[i-1], i > 1 ? X[i-2] : "")))
+        else if (m==0)
         {
-            A_1.insert(A_1.begin(), X[i-1]);
-            A_2.insert(A_2.begin(), "-");
-            i--;
+            for (std::size_t i=x_begin; i<x_end; i++)
+            {
+                ZWpair.first.emplace_back(workspace.X[i]);
+                ZWpair.second.emplace_back(PHONEME::GAP);
+                distance += workspace.gaps_x[i];
+            }
         }
-
         else
         {
-            A_1.insert(A_1.begin(), "-");
-            A_2.insert(A_2.begin(), Y[j-1]);
-            j--;
+            distance = NeedlemanWunschAppend(workspace.X.subspan(x_begin, n), workspace.Y.subspan(y_begin, m),
+                                             workspace.gaps_x.subspan(x_begin, n),
+                                             workspace.gaps_y.subspan(y_begin, m), ZWpair);
         }
+        if (distance > max_distance)
+        {
+            ZWpair.first.resize(start);
+            ZWpair.second.resize(start);
+            return DISTANCE_OVER_BOUND;
+        }
+        return distance;
     }
-    
-    alignment_and_distance.ZWpair.first = A_1;
-    alignment_and_distance.ZWpair.second = A_2;
-    return alignment_and_distance;
-}
-
 
-std::vector<int> sum_vectors(const std::vector<int>& v1, const std::vector<int>& v2)
-{
-    std::vector<int> vector_sum;
-    if(v1.size() != v2.size())
+    const std::size_t xmid = x_begin + n/2; //defect truncation (.5 -> .0)
+    const std::size_t X_size = workspace.X.size();
+    const std::size_t Y_size = workspace.Y.size();
+
+    // scoreL[k]: X[x_begin, xmid) against Y[y_begin, y_begin+k)
+    // scoreR[k]: X[xmid, x_end) against Y[y_end-k, y_end), computed over the reversed ranges
+    struct SplitScratch;
+    const std::span<int> scores{scratch_buffer<int, SplitScratch>(2 * (m + 1))};
+    const std::span<int> scoreL = scores.first(m + 1);
+    const std::span<int> scoreR = scores.subspan(m + 1);
+    const auto X_left = workspace.X.subspan(x_begin, xmid - x_begin);
+    const auto X_right_rev = workspace.X_rev.subspan(X_size - x_end, x_end - xmid);
+    const auto Y_range = workspace.Y.subspan(y_begin, m);
+    const auto Y_range_rev = workspace.Y_rev.subspan(Y_size - y_end, m);
+    const auto gaps_x_left = workspace.gaps_x.subspan(x_begin, xmid - x_begin);
+    const auto gaps_x_right_rev = workspace.gaps_x_rev.subspan(X_size - x_end, x_end - xmid);
+    const auto gaps_y_range = workspace.gaps_y.subspan(y_begin, m);
+    const auto gaps_y_range_rev = workspace.gaps_y_rev.subspan(Y_size - y_end, m);
+    const PhonemeCostTable& costs = phoneme_cost_table();
+
+    const auto fill_left = [&] {
+        if (max_distance < DISTANCE_OVER_BOUND)
+            levenshtein_last_row_bounded(X_left, Y_range, gaps_x_left, gaps_y_range, costs, max_distance, scoreL);
+        else
+            levenshtein_last_row(X_left, Y_range, gaps_x_left, gaps_y_range, costs, scoreL);
+    };
+    const auto fill_right = [&] {
+        if (max_distance < DISTANCE_OVER_BOUND)
+            levenshtein_last_row_bounded(X_right_rev, Y_range_rev, gaps_x_right_rev, gaps_y_range_rev, costs, max_distance, scoreR);
+        else
+            levenshtein_last_row(X_right_rev, Y_range_rev, gaps_x_right_rev, gaps_y_range_rev, costs, scoreR);
+    };
+    const bool parallel = workspace.pool != nullptr && n * m >= HIRSCHBERG_PARALLEL_CELLS;
+    if (parallel)
     {
-        std::cerr << "In vector sum: vector dimensions are not equal!" << std::endl;
-        std::exit(EXIT_FAILURE);
+        workspace.pool->fork_join(fill_left, fill_right);
     }
-    for (std::size_t i=0; i < v1.size();i++)
+    else
     {
-        vector_sum.push_back(v1[i] + v2[i]);
+        fill_left();
+        fill_right();
     }
-    
-    return vector_sum;
-}
 
-
-std::size_t argmin_element(const std::vector<int> score)
-{
-    int min = score[0];
-    std::size_t min_index=0;
-    for (std::size_t i=1; i < score.size();i++)
+    // Split Y where the two halves add up to the least, saturating so that DISTANCE_OVER_BOUND stays over
+    std::size_t ymid = 0;
+    int distance = DISTANCE_OVER_BOUND;
+    for (std::size_t k=0; k<=m; k++)
     {
-        if(min > score[i])
+        const int sum = scoreL[k] > DISTANCE_OVER_BOUND - scoreR[m-k] ? DISTANCE_OVER_BOUND : scoreL[k] + scoreR[m-k];
+        if (sum < distance)
         {
-            min = score[i];
-            min_index = i;
+            distance = sum;
+            ymid = y_begin + k;
         }
     }
-    
-    return min_index;
+    if (distance > max_distance)
+    {
+        return DISTANCE_OVER_BOUND;
+    }
+
+    if (parallel)
+    {
+        PhonemeAlignment right{};
+        workspace.pool->fork_join([&] { hirschberg_range(workspace, ZWpair, x_begin, xmid, y_begin, ymid); },
+                                  [&] { hirschberg_range(workspace, right, xmid, x_end, ymid, y_end); });
+        ZWpair.first.insert(ZWpair.first.end(), right.first.begin(), right.first.end());
+        ZWpair.second.insert(ZWpair.second.end(), right.second.begin(), right.second.end());
+    }
+    else
+    {
+        hirschberg_range(workspace, ZWpair, x_begin, xmid, y_begin, ymid);
+        hirschberg_range(workspace, ZWpair, xmid, x_end, ymid, y_end);
+    }
+    return distance;
 }
 
-//overload pair sum
-std::pair<std::vector<std::string>, std::vector<std::string>> operator+(std::pair<std::vector<std::string>, std::vector<std::string>> const& one, std::pair<std::vector<std::string>, std::vector<std::string>> const& two)
+Phoneme_Alignment_And_Distance hirschberg(std::span<const PhonemeId> X, std::span<const PhonemeId> Y)
 {
-    std::pair<std::vector<std::string>, std::vector<std::string>> pair_sum;
-   //  pair_sum.first = one.first + two.first;
-   pair_sum.first = one.first;
-   pair_sum.first.insert(pair_sum.first.end(), two.first.begin(), two.first.end());
-   //  pair_sum.second = one.second + two.second;
-   pair_sum.second = one.second;
-   pair_sum.second.insert(pair_sum.second.end(), two.second.begin(), two.second.end());
-    return pair_sum;
+    return hirschberg(X, Y, DISTANCE_OVER_BOUND);
 }
 
+// Aligns the whole of workspace's X and Y, see hirschberg()
+inline Phoneme_Alignment_And_Distance hirschberg_workspace(const Hirschberg_Workspace& workspace, int max_distance)
+{
+    Phoneme_Alignment_And_Distance alignment_and_distance{};
+    if (max_distance < 0)
+    {
+        alignment_and_distance.distance = DISTANCE_OVER_BOUND;
+        return alignment_and_distance;
+    }
+
+    const std::size_t n = workspace.X.size(), m = workspace.Y.size();
+    alignment_and_distance.ZWpair.first.reserve(n + m);
+    alignment_and_distance.ZWpair.second.reserve(n + m);
+    alignment_and_distance.distance = hirschberg_range(workspace, alignment_and_distance.ZWpair, 0, n, 0, m, max_distance);
+    return alignment_and_distance;
+}
 
+Phoneme_Alignment_And_Distance hirschberg(std::span<const PhonemeId> X, std::span<const PhonemeId> Y, int max_distance)
+{
+    return hirschberg_workspace(Hirschberg_Workspace{X, Y}, max_distance);
+}
 
-Alignment_And_Distance hirschberg(const std::vector<std::string>& X, const std::vector<std::string>& Y)
+Phoneme_Alignment_And_Distance hirschberg(std::span<const PhonemeId> X, std::span<const PhonemeId> Y, int max_distance, Task_Pool& pool)
 {
-    Alignment_And_Distance alignment_and_distance{};
+    // The workspace is built on this thread, the tasks only read it
+    return hirschberg_workspace(Hirschberg_Workspace{X, Y, &pool}, max_distance);
+}
 
-    const int n = X.size();
-    const int m = Y.size();
-    std::pair< std::vector<std::string>, std::vector<std::string> > ZWpair{};
-    
-    
-    if (n==0)
-    {
-        for (int i=1; i<=m; i++)
-        {
-            ZWpair.first.emplace_back("-");
-            ZWpair.second.emplace_back(Y[i-1]);
-            alignment_and_distance.distance += GAP_PENALTY(Y[i-1], i > 1 ? Y[i-2] : "");
-        }
-        
-    }
-    
-    else if (m==0)
+/**
+ * Banded counterpart of hirschberg(): only the cells within band diagonals of the corner to corner diagonal are filled, in O(n * band) time.
+ *
+ * The band already keeps memory linear in n, so rather than recursing this is NeedlemanWunsch() over the band: 2 bits of traceback per cell, stored relative to the band, so row i's cell j is at j - i - lowest.
+ *
+ * @return (Banded_Alignment_And_Distance): the best alignment within the band, its cost, and whether it is provably the best overall (see levenshtein_distance_banded())
+*/
+Banded_Alignment_And_Distance hirschberg_banded(std::span<const PhonemeId> X, std::span<const PhonemeId> Y, std::size_t band)
+{
+    const std::size_t n = X.size(), m = Y.size();
+    const PhonemeCostTable& costs = phoneme_cost_table();
+    const Band bounds{n, m, band};
+    const std::size_t band_cells = static_cast<std::size_t>(bounds.highest - bounds.lowest) + 1;
+    const std::size_t row_words = (band_cells + 31) / 32;
+    const auto offset = [&](std::size_t i, std::size_t j) {
+        return static_cast<std::size_t>(static_cast<std::ptrdiff_t>(j) - static_cast<std::ptrdiff_t>(i) - bounds.lowest);
+    };
+
+    struct BandedRowScratch;
+    struct BandedTracebackScratch;
+    const std::span<int> scratch{scratch_buffer<int, BandedRowScratch>(n + m + 2 * (m+1))};
+    const std::span<int> gaps_x{scratch.first(n)};
+    const std::span<int> gaps_y{scratch.subspan(n, m)};
+    gap_penalties(X, gaps_x);
+    gap_penalties(Y, gaps_y);
+    int* prev = scratch.data() + n + m;
+    int* curr = prev + m+1;
+    const std::span<std::uint64_t> traceback{scratch_buffer<std::uint64_t, BandedTracebackScratch>((n+1) * row_words)};
+    const auto set_step = [&](std::size_t i, std::size_t j, Traceback step) {
+        const std::size_t t = offset(i, j);
+        std::uint64_t& word = traceback[i * row_words + t / 32];
+        word = (word & ~(0b11ull << (2 * (t % 32)))) | (static_cast<std::uint64_t>(step) << (2 * (t % 32)));
+    };
+    const auto get_step = [&](std::size_t i, std::size_t j) {
+        const std::size_t t = offset(i, j);
+        return static_cast<Traceback>((traceback[i * row_words + t / 32] >> (2 * (t % 32))) & 0b11);
+    };
+
+    //STEP 1: first row, as in levenshtein_distance_banded() only the cells just past the band are read outside it
+    constexpr int outside{DISTANCE_OVER_BOUND / 2};
+    prev[0] = 0;
+    for (std::size_t j=1;j<=bounds.last(0, m);j++)
     {
-        for (int i=1; i<=n; i++)
-        {
-            ZWpair.first.emplace_back(X[i-1]);
-            ZWpair.second.emplace_back("-");
-            alignment_and_distance.distance += GAP_PENALTY(X[i-1], i > 1 ? X[i-2] : "");
-        }
+        prev[j] = prev[j-1] + gaps_y[j-1];
+        set_step(0, j, Traceback::Left);
     }
-    
-    else if (n==1 || m ==1)
+    if (bounds.last(0, m) < m)
     {
-        alignment_and_distance = NeedlemanWunsch(X,Y);
+        prev[bounds.last(0, m) + 1] = outside;
     }
-    
-    else
+
+    //STEP 2: the band of each row, ties go to the diagonal, then up
+    for (std::size_t i=1;i<=n;i++)
     {
-        const int xmid = n/2; //defect truncation (.5 -> .0)
-        std::vector<std::string> X_to_xmid{},
-                                 X_from_xmid{},
-                                 X_from_xmid_rev{},
-                                 Y_to_ymid{},
-                                 Y_from_ymid{},
-                                 Y_rev{};
-        
-        //generate x[1...xmid]
-        for (int i=0;i<xmid;i++)
-        {
-            X_to_xmid.emplace_back(X[i]);
-        }
-        
-        //reverse X[xmid+1 ... n] and get normal
-        for (int i=0;i<(n-xmid);i++)
-        {
-            X_from_xmid_rev.emplace_back(X[n-1-i]);
-            X_from_xmid.emplace_back(X[xmid+i]);
-        }
-        
-        //reverse Y
-        for (int i=1;i<=m;i++)
+        const std::size_t first = bounds.first(i);
+        const std::size_t last = bounds.last(i, m);
+        const int* substitution_row = costs.substitution_row(X[i-1]);
+        const int deletion_cost = gaps_x[i-1];
+        int left = outside;
+        for (std::size_t j=first;j<=last;j++)
         {
-             Y_rev.emplace_back(Y[m-i]);
-        }
-        
-        std::vector<int> scoreL = NWScore(X_to_xmid,Y);
-        std::vector<int> scoreR = NWScore(X_from_xmid_rev,Y_rev);
-        std::vector<int> scoreR_rev;
-        
-        //DEBUG
-        #ifdef DEBUG
-            std::cout << "ScoreL : ";
-            for (int i=0; i<scoreL.size();i++)
-            {
-                std::cout << scoreL[i] << "\t";
-            }
-            std::cout << std::endl;
-            
-            //DEBUG
-            std::cout << "ScoreR : ";
-            for (int i=0; i<scoreR.size();i++)
+            int best = prev[j] + deletion_cost;
+            Traceback step = Traceback::Up;
+            if (j > 0)
             {
-                std::cout << scoreR[i] << "\t";
+                const int diagonal = prev[j-1] + substitution_row[Y[j-1]];
+                const int insertion = left + gaps_y[j-1];
+                if (diagonal <= best) { best = diagonal; step = Traceback::Diagonal; }
+                if (insertion < best) { best = insertion; step = Traceback::Left; }
             }
-            std::cout << std::endl;
-        #endif //DEBUG
-        
-        //reverse ScoreR
-        for (std::size_t i=1;i<=scoreR.size();i++)
-        {
-            scoreR_rev.push_back(scoreR[scoreR.size()-i]);
+            left = std::min(best, outside);
+            curr[j] = left;
+            set_step(i, j, step);
         }
-        
-        auto vector_sum = sum_vectors(scoreL, scoreR_rev);
-        const std::size_t ymid = argmin_element(vector_sum);
-        alignment_and_distance.distance = *std::min_element(vector_sum.begin(), vector_sum.end());
-        
-        //DEBUG
-        #ifdef DEBUG
-            std::cout << "ymid : " << ymid << std::endl;
-        #endif //DEBUG
-        
-        //generate Y[1...ymid]
-        for (std::size_t i=0;i<ymid;i++)
+        if (last < m)
         {
-            Y_to_ymid.emplace_back(Y[i]);
+            curr[last + 1] = outside;
         }
-        
-        //reverse X[xmid+1 ... n]
-        // ^^ original comment, but seems wrong
-        for (int i=ymid;i<m;i++)
+        std::swap(prev, curr);
+    }
+
+    //STEP 3: Reconstruct alignment backwards, then put it in order
+    Banded_Alignment_And_Distance result{};
+    result.distance = prev[m];
+    result.optimal = bounds.covers_all || result.distance <= band_escape_cost(n, m, band, min_gap_penalty(gaps_x, gaps_y));
+    result.ZWpair.first.reserve(n + m);
+    result.ZWpair.second.reserve(n + m);
+    std::size_t i = n, j = m;
+    while (i>0 || j>0)
+    {
+        switch (get_step(i, j))
         {
-            Y_from_ymid.emplace_back(Y[i]);
+            case Traceback::Diagonal:
+                result.ZWpair.first.push_back(X[--i]);
+                result.ZWpair.second.push_back(Y[--j]);
+                break;
+            case Traceback::Up:
+                result.ZWpair.first.push_back(X[--i]);
+                result.ZWpair.second.push_back(PHONEME::GAP);
+                break;
+            case Traceback::Left:
+                result.ZWpair.first.push_back(PHONEME::GAP);
+                result.ZWpair.second.push_back(Y[--j]);
+                break;
         }
-        
-        
-        ZWpair = hirschberg(X_to_xmid, Y_to_ymid).ZWpair + hirschberg(X_from_xmid, Y_from_ymid).ZWpair;
-        alignment_and_distance.ZWpair = ZWpair;
     }
-    return alignment_and_distance;
+    std::reverse(result.ZWpair.first.begin(), result.ZWpair.first.end());
+    std::reverse(result.ZWpair.second.begin(), result.ZWpair.second.end());
+    return result;
+}
+
+Alignment_And_Distance hirschberg(const std::vector<std::string>& X, const std::vector<std::string>& Y)
+{
+    return to_alignment_and_distance(hirschberg(phones_to_ids(X), phones_to_ids(Y)));
 }
@@ -1,21 +1,74 @@
 #pragma once
 
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
 #include <iostream>
 #include <string>
-#include <sstream>
+#include <string_view>
+#include <vector>
+
+/**
+ * Splits a CMU style space-separated string of phonemes without copying or allocating. Iterating yields each phoneme as a string_view into the original string, which has to outlive the iteration:
+ *
+ *  for (std::string_view phone : PhoneTokens{"K EH2 R IY0"}) { ... }
+ *
+ * Splits on any whitespace, like reading the string with operator>>.
+*/
+class PhoneTokens {
+public:
+    class iterator {
+    public:
+        using value_type = std::string_view;
+        using difference_type = std::ptrdiff_t;
+
+        iterator() = default;
+        explicit iterator(std::string_view rest) : rest{rest} { advance(); }
+
+        std::string_view operator*() const { return token; }
+        iterator& operator++() { advance(); return *this; }
+        iterator operator++(int) { iterator previous{*this}; advance(); return previous; }
+        // Every token starts at a different character, and a finished iterator, like end(), has none
+        bool operator==(const iterator& other) const { return token.data() == other.token.data(); }
+
+    private:
+        static constexpr std::string_view WHITESPACE{" \t\n\v\f\r"};
+
+        void advance() {
+            const std::size_t start{rest.find_first_not_of(WHITESPACE)};
+            if (start == std::string_view::npos) {
+                rest = {};
+                token = {};
+                return;
+            }
+            const std::size_t end{std::min(rest.find_first_of(WHITESPACE, start), rest.size())};
+            token = rest.substr(start, end - start);
+            rest.remove_prefix(end);
+        }
+
+        std::string_view rest{};
+        std::string_view token{};
+    };
+
+    explicit PhoneTokens(std::string_view phones) : phones{phones} {}
+
+    iterator begin() const { return iterator{phones}; }
+    iterator end() const { return iterator{}; }
+
+private:
+    std::string_view phones{};
+};
 
 /**
  * Convert CMU style space-separated string of phonemes to vector of separated symbols.
  * 
- * @param phones (string): string of space-separated phonemes
+ * @param phones (string_view): string of space-separated phonemes
  * @return (vector<string>): vector of phoneme symbols
 */
-inline std::vector<std::string> phones_string_to_vector(const std::string& phones) {
+inline std::vector<std::string> phones_string_to_vector(std::string_view phones) {
     std::vector<std::string> result{};
-    std::istringstream iss{phones};
-    std::string word{};
-    while(iss >> word) {
-        result.emplace_back(word);
+    for (const std::string_view phone : PhoneTokens{phones}) {
+        result.emplace_back(phone);
     }
     return result;
 }
@@ -40,7 +93,7 @@ inline std::string phones_vector_to_string(std::vector<std::string> vector) {
 
 // Naive hack relying on CMU phoneme format to detect vowels using the accent indicator.
 inline bool is_vowel(const std::string& phoneme) {
-    return std::isdigit(phoneme.back());
+    return std::isdigit(static_cast<unsigned char>(phoneme.back()));
 }   
 
 
@@ -2,8 +2,15 @@
 
 #include "convenience.hpp"
 #include "consonant_distance.hpp"
+#include "phoneme_id.hpp"
 #include "vowel_hex_graph.hpp"
+#include <algorithm>
+#include <array>
 #include <cstdlib>
+#include <limits>
+#include <span>
+#include <string>
+#include <vector>
 
 namespace CONSTANTS{ 
 
@@ -100,7 +107,6 @@ inline int SUBSTITUTION_SCORE(const std::string& s1, const std::string& s2) {
       }
       else {
          // Check vowel distance.
-         VowelHexGraph::initialize();
          int vowel_distance{VowelHexGraph::get_distance(v1, v2)};
          if (stress1 != stress2) {
             return (vowel_distance * CONSTANTS::VOWEL::COEFFICIENT) + CONSTANTS::VOWEL::STRESS_PENALTY;
@@ -123,3 +129,197 @@ inline int SUBSTITUTION_SCORE(const std::string& s1, const std::string& s2) {
       }
    }
 }
+
+/**
+ * Dense phoneme-by-phoneme cost table, so that each DP cell costs one table load instead of a walk down the SUBSTITUTION_SCORE() branch tree.
+ *
+ * Built once, from the string versions of SUBSTITUTION_SCORE() and GAP_PENALTY() above, which stay as the reference path.
+ *
+ * USAGE:
+ *
+ * const PhonemeCostTable& costs{phoneme_cost_table()};
+ * costs.substitution_score(id1, id2);
+*/
+struct PhonemeCostTable {
+   // substitution[p1 * PHONEME::COUNT + p2]
+   std::array<int, PHONEME::COUNT * PHONEME::COUNT> substitution{};
+   // insertion/deletion penalty when the phoneme doesn't repeat its predecessor
+   std::array<int, PHONEME::COUNT> gap{};
+   // cheapest substitution of the phoneme by a different one, either way round
+   std::array<int, PHONEME::COUNT> nearest{};
+   // largest entry of either table, bounds how much a DP cell can grow per step
+   int max_cost{};
+
+   int substitution_score(PhonemeId p1, PhonemeId p2) const {
+      return substitution[p1 * PHONEME::COUNT + p2];
+   }
+
+   // Row of substitution scores against p1, index it with the other PhonemeId.
+   const int* substitution_row(PhonemeId p1) const {
+      return substitution.data() + p1 * PHONEME::COUNT;
+   }
+
+   int gap_penalty(PhonemeId phoneme, PhonemeId prev_phoneme = PHONEME::GAP) const {
+      if (phoneme == prev_phoneme && !is_vowel(phoneme)) {
+         return CONSTANTS::CONSONANT::REPEATED_CONSONANT_PENALTY;
+      }
+      return gap[phoneme];
+   }
+};
+
+inline PhonemeCostTable build_phoneme_cost_table() {
+   PhonemeCostTable table{};
+   for (std::size_t i{}; i < PHONEME::COUNT; ++i) {
+      const std::string phoneme1{id_to_phoneme(static_cast<PhonemeId>(i))};
+      table.gap[i] = GAP_PENALTY(phoneme1);
+      for (std::size_t j{}; j < PHONEME::COUNT; ++j) {
+         table.substitution[i * PHONEME::COUNT + j] = SUBSTITUTION_SCORE(phoneme1, id_to_phoneme(static_cast<PhonemeId>(j)));
+      }
+   }
+   for (std::size_t i{}; i < PHONEME::COUNT; ++i) {
+      table.nearest[i] = std::numeric_limits<int>::max();
+      for (std::size_t j{}; j < PHONEME::COUNT; ++j) {
+         if (i != j) {
+            table.nearest[i] = std::min({table.nearest[i], table.substitution[i * PHONEME::COUNT + j], table.substitution[j * PHONEME::COUNT + i]});
+         }
+      }
+   }
+   table.max_cost = std::max(*std::max_element(table.substitution.begin(), table.substitution.end()),
+                             *std::max_element(table.gap.begin(), table.gap.end()));
+   return table;
+}
+
+// The table is built on first use.
+inline const PhonemeCostTable& phoneme_cost_table() {
+   static const PhonemeCostTable table{build_phoneme_cost_table()};
+   return table;
+}
+
+// PhonemeId version of GAP_PENALTY, pass PHONEME::GAP as prev_phoneme when there is none.
+inline int GAP_PENALTY(PhonemeId phoneme, PhonemeId prev_phoneme = PHONEME::GAP) {
+   return phoneme_cost_table().gap_penalty(phoneme, prev_phoneme);
+}
+
+// PhonemeId version of SUBSTITUTION_SCORE
+inline int SUBSTITUTION_SCORE(PhonemeId p1, PhonemeId p2) {
+   return phoneme_cost_table().substitution_score(p1, p2);
+}
+
+/**
+ * gap_penalties() into a buffer the caller already has.
+ *
+ * @param phonemes (span<const PhonemeId>): interned phonemes
+ * @param penalties (span<int>): output, phonemes.size() cells
+*/
+inline void gap_penalties(std::span<const PhonemeId> phonemes, std::span<int> penalties) {
+   const PhonemeCostTable& costs{phoneme_cost_table()};
+   for (std::size_t i{}; i < phonemes.size(); ++i) {
+      penalties[i] = costs.gap_penalty(phonemes[i], i > 0 ? phonemes[i-1] : PHONEME::GAP);
+   }
+}
+
+/**
+ * Gap penalties for every position of a sequence, including the repeated consonant discount, so DP loops don't recompute them per cell.
+ *
+ * @param phonemes (span<const PhonemeId>): interned phonemes
+ * @return (vector<int>): gap_penalties[i] == GAP_PENALTY(phonemes[i], phonemes[i-1])
+*/
+inline std::vector<int> gap_penalties(std::span<const PhonemeId> phonemes) {
+   std::vector<int> penalties(phonemes.size());
+   gap_penalties(phonemes, penalties);
+   return penalties;
+}
+
+/**
+ * Where the rhyme of a pronunciation starts, the same as Phonetic::get_rhyming_part(): its last vowel with primary stress, else its last vowel, else its start.
+ *
+ * @param phonemes (span<const PhonemeId>): interned phonemes, e.g. the end of a line
+ * @return (size_t): index of the first phoneme of the rhyme
+*/
+inline std::size_t rhyme_start(std::span<const PhonemeId> phonemes) {
+   std::size_t last_vowel{phonemes.size()};
+   for (std::size_t i{phonemes.size()}; i-- > 0;) {
+      if (is_vowel(phonemes[i])) {
+         if (vowel_stress(phonemes[i]) == 1) {
+            return i;
+         }
+         if (last_vowel == phonemes.size()) {
+            last_vowel = i;
+         }
+      }
+   }
+   return last_vowel == phonemes.size() ? 0 : last_vowel;
+}
+
+// Vowels from rhyme_start() to the end, i.e. the syllables of the rhyme
+inline std::size_t rhyme_syllables(std::span<const PhonemeId> phonemes) {
+   const auto rhyme{phonemes.subspan(rhyme_start(phonemes))};
+   return static_cast<std::size_t>(std::count_if(rhyme.begin(), rhyme.end(), [](PhonemeId p) { return is_vowel(p); }));
+}
+
+// Start of the last syllables vowels of phonemes (counting every vowel, stressed or not), or rhyme_start() if the rhyme has fewer
+inline std::size_t rhyme_tail_start(std::span<const PhonemeId> phonemes, std::size_t syllables) {
+   const std::size_t start{rhyme_start(phonemes)};
+   for (std::size_t i{phonemes.size()}; i-- > start;) {
+      if (is_vowel(phonemes[i]) && --syllables == 0) {
+         return i;
+      }
+   }
+   return start;
+}
+
+/**
+ * Gap penalties for aligning two line ends by their rhymes, the way end_rhyme_distance() and end_rhyme_alignment() do.
+ *
+ * Both rhymes are cut to the syllables of the shorter (at least one), as compare_end_line_rhyming_parts() cuts rhyming parts, and whatever comes before the cut costs nothing to drop. So one DP over the whole of both line ends is anchored at their ends, with their leading material free, and since a line end can span several words, so can its rhyme, e.g. when the last word is unstressed.
+ *
+ * @param phonemes1 (span<const PhonemeId>): interned phonemes of one line end
+ * @param phonemes2 (span<const PhonemeId>): interned phonemes of the other
+ * @param gaps1 (span<int>): output, phonemes1.size() cells
+ * @param gaps2 (span<int>): output, phonemes2.size() cells
+*/
+inline void end_rhyme_gap_penalties(std::span<const PhonemeId> phonemes1, std::span<const PhonemeId> phonemes2, std::span<int> gaps1, std::span<int> gaps2) {
+   const std::size_t syllables{std::max<std::size_t>(1, std::min(rhyme_syllables(phonemes1), rhyme_syllables(phonemes2)))};
+   gap_penalties(phonemes1, gaps1);
+   gap_penalties(phonemes2, gaps2);
+   std::fill_n(gaps1.begin(), rhyme_tail_start(phonemes1, syllables), 0);
+   std::fill_n(gaps2.begin(), rhyme_tail_start(phonemes2, syllables), 0);
+}
+
+// Returned by the bounded distance functions (levenshtein_distance(), NWScore() and hirschberg() with a max_distance) when the distance is over the bound. Compares greater than any real distance.
+inline constexpr int DISTANCE_OVER_BOUND{std::numeric_limits<int>::max()};
+
+/**
+ * Whether a DP over sequences of these lengths can keep its scores in Score.
+ *
+ * Every cell is at most the cost of some path to it, one step per phoneme, and the candidates compared before taking the minimum add one more step, so (len1 + len2 + 1) * max_cost bounds everything the DP ever stores. Where halving the scores pays off (the batch kernel's lanes) the DP is templated on the score type and uses 16 bit scores whenever this holds for std::int16_t, which for rhyming parts is always.
+ *
+ * @param len1 (size_t): length of one sequence
+ * @param len2 (size_t): length of the other
+ * @param max_cost (int): PhonemeCostTable::max_cost
+ * @return (bool): true if every score fits in Score
+*/
+template<typename Score>
+constexpr bool scores_fit(std::size_t len1, std::size_t len2, int max_cost) {
+   return (len1 + len2 + 1) * static_cast<std::size_t>(max_cost) <= static_cast<std::size_t>(std::numeric_limits<Score>::max());
+}
+
+/**
+ * Per-thread buffer for a DP's temporary rows, which only ever grows, so that once a thread has seen its longest sequences the fills stop allocating.
+ *
+ * Every Tag has a buffer of its own, so a function holding one can call another that uses a different Tag. The contents are whatever the last user left, and a function must not be re-entered while its span is in use.
+ *
+ *  struct MyRowsScratch;
+ *  std::span<int> rows{scratch_buffer<int, MyRowsScratch>(2 * (m + 1))};
+ *
+ * @param size (size_t): number of elements needed
+ * @return (span<T>): size elements, valid until the next call with the same T and Tag on this thread
+*/
+template<typename T, typename Tag>
+std::span<T> scratch_buffer(std::size_t size) {
+   thread_local std::vector<T> buffer{};
+   if (buffer.size() < size) {
+      buffer.resize(size);
+   }
+   return std::span<T>{buffer}.first(size);
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+/**
+ * SIMD kernels for the weighted edit distance DP, and the runtime dispatch between them.
+ *
+ * Each instruction set's kernels live in their own translation unit (see the distance_kernels target in CMakeLists.txt), and return exactly what the scalar fill in levenshtein_distance.hpp returns. Every variant the compiler can build goes into the same binary, and which one runs is decided once, the first time a kernel is asked for, from what the CPU supports.
+ *
+ * AVX-512 is only picked for sequences of at least AVX512_MIN_LENGTH phonemes, shorter ones go to AVX2.
+ *
+ * Setting the environment variable RHYME_AND_METER_ISA to "scalar", "avx2" or "avx512" picks a variant by hand, at every length, e.g. to test the fallbacks on a machine that supports more. It can't pick one the CPU doesn't support.
+*/
+
+#include "distance.hpp"
+#include "phoneme_id.hpp"
+
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <string_view>
+
+// Instruction sets with kernels, in increasing order of preference.
+enum class KernelIsa {
+    Scalar,
+    AVX2,
+    AVX512
+};
+
+/**
+ * Fills last_row with the last row of the weighted Levenshtein DP of X against Y, i.e. last_row[j] is the distance from X to Y[0, j).
+ *
+ * X and Y must not be empty, last_row must have Y.size() + 1 cells.
+*/
+using LastRowKernel = void (*)(std::span<const PhonemeId> X, std::span<const PhonemeId> Y,
+                               std::span<const int> gaps_x, std::span<const int> gaps_y,
+                               const PhonemeCostTable& costs, std::span<int> last_row);
+
+/**
+ * Fills a block of a larger weighted Levenshtein DP: the same fill as LastRowKernel, but starting from the first row and column given, rather than running sums of the gap penalties.
+ *
+ * top has Y.size() + 1 cells, D(0, j), left has X.size() + 1 cells, D(i, 0), and top[0] == left[0]. On return top holds the last row, D(n, j), and left the last column, D(i, m).
+ *
+ * X and Y must not be empty.
+*/
+using BlockKernel = void (*)(std::span<const PhonemeId> X, std::span<const PhonemeId> Y,
+                             std::span<const int> gaps_x, std::span<const int> gaps_y,
+                             const PhonemeCostTable& costs, std::span<int> top, std::span<int> left);
+
+// Scores one query against many candidates, distances[k] is the distance from query to candidates[k]. Candidates go through the lanes in the order given, so sorting them by length keeps the padding down.
+using BatchKernel = void (*)(std::span<const PhonemeId> query, std::span<const int> query_gaps,
+                             std::span<const std::span<const PhonemeId>> candidates,
+                             std::span<int> distances,
+                             const PhonemeCostTable& costs);
+
+// Below this many phonemes on the shorter side the anti-diagonals are too short to fill a vector, and the scalar fill wins.
+inline constexpr std::size_t SIMD_MIN_LENGTH{16};
+
+// Below this many phonemes on the shorter side AVX-512 is slower than AVX2 (2.31 vs 1.71 ns/cell at 24, 1.11 vs 1.02 at 64), its longer vectors spend more of each anti-diagonal ramping up and down. From about here on it wins (0.53 vs 0.75 ns/cell at 200).
+inline constexpr std::size_t AVX512_MIN_LENGTH{200};
+
+/**
+ * @param name (string_view): "scalar", "avx2" or "avx512"
+ * @return (optional<KernelIsa>): the matching instruction set, empty for anything else
+*/
+std::optional<KernelIsa> parse_kernel_isa(std::string_view name);
+
+// Whether kernels for isa were built and this CPU can run them. Always true for KernelIsa::Scalar.
+bool kernel_isa_available(KernelIsa isa);
+
+// Best available instruction set, lowered by RHYME_AND_METER_ISA if it is set. Decided on the first call.
+KernelIsa kernel_isa();
+
+// kernel_isa() for sequences whose shorter side has length phonemes: AVX2 rather than AVX-512 below AVX512_MIN_LENGTH, unless RHYME_AND_METER_ISA asks for AVX-512.
+KernelIsa kernel_isa(std::size_t length);
+
+// Last row kernel for isa, nullptr for KernelIsa::Scalar (use levenshtein_last_row_scalar()) or when isa isn't available.
+LastRowKernel last_row_kernel(KernelIsa isa);
+
+// Block kernel for isa, nullptr for KernelIsa::Scalar (use levenshtein_block_scalar()) or when isa isn't available.
+BlockKernel block_kernel(KernelIsa isa);
+
+// Batch kernel for isa, nullptr when there is none for isa or it isn't available. It picks 16 or 32 bit lanes per group of candidates by itself.
+BatchKernel batch_kernel(KernelIsa isa);
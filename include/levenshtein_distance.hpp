@@ -1,13 +1,114 @@
 #pragma once
 
 #include "distance.hpp"
+#include "distance_kernels.hpp"
 #include "convenience.hpp"
 #include "vowel_hex_graph.hpp"
 #include "consonant_distance.hpp"
+#include "phoneme_id.hpp"
+#include "task_pool.hpp"
 
 #include <iostream>
 #include <vector>
 #include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <numeric>
+#include <span>
+#include <string_view>
+
+/**
+ * One row of the weighted Levenshtein DP from the row above it, for one more phoneme of the sequence along the rows.
+ *
+ * @param prev (const int*): the row above, symbols2.size() + 1 cells
+ * @param curr (int*): output, symbols2.size() + 1 cells
+ * @param symbol1 (PhonemeId): the row's phoneme
+ * @param deletion_cost (int): its gap penalty
+ * @param symbols2 (span<const PhonemeId>): interned phonemes, columns
+ * @param gaps2 (span<const int>): gap_penalties(symbols2)
+ * @param costs (PhonemeCostTable): substitution scores
+ */
+inline void levenshtein_next_row(const int* prev, int* curr, PhonemeId symbol1, int deletion_cost,
+                                 std::span<const PhonemeId> symbols2, std::span<const int> gaps2, const PhonemeCostTable& costs) {
+    // Base case, other axis
+    curr[0] = prev[0] + deletion_cost;
+    const int* substitution_row{costs.substitution_row(symbol1)};
+    for (size_t j = 1; j <= symbols2.size(); ++j) {
+        curr[j] = std::min({
+            prev[j] + deletion_cost,     // Deletion of symbol from phones1
+            curr[j - 1] + gaps2[j - 1],  // Insertion of symbol from phones2
+            prev[j - 1] + substitution_row[symbols2[j - 1]] // Substitution
+        });
+    }
+}
+
+/**
+ * Scalar row-by-row fill of the weighted Levenshtein DP. This is the reference the SIMD kernels in distance_kernels.hpp are checked against.
+ *
+ * Rows stay 32 bit: whenever 16 bit scores would fit (see scores_fit()) the rows fit in L1 anyway, and narrowing every store made the fill slower.
+ *
+ * @param symbols1 (span<const PhonemeId>): interned phonemes, rows
+ * @param symbols2 (span<const PhonemeId>): interned phonemes, columns
+ * @param gaps1 (span<const int>): gap_penalties(symbols1)
+ * @param gaps2 (span<const int>): gap_penalties(symbols2)
+ * @param costs (PhonemeCostTable): substitution scores
+ * @param last_row (span<int>): output, symbols2.size() + 1 cells, last_row[j] is the distance from symbols1 to the first j phonemes of symbols2
+ */
+inline void levenshtein_last_row_scalar(std::span<const PhonemeId> symbols1, std::span<const PhonemeId> symbols2,
+                                        std::span<const int> gaps1, std::span<const int> gaps2,
+                                        const PhonemeCostTable& costs, std::span<int> last_row) {
+    size_t len1 = symbols1.size();
+    size_t len2 = symbols2.size();
+
+    // Two rows for dynamic programming, one of them is last_row
+    struct OtherRowScratch;
+    std::span<int> other_row{scratch_buffer<int, OtherRowScratch>(len2 + 1)};
+    int* prev = last_row.data();
+    int* curr = other_row.data();
+
+    // Initialize base cases with running sums of the gap penalties, which also covers the empty cases
+    prev[0] = 0;
+    for (size_t j = 1; j <= len2; ++j) {
+      prev[j] = prev[j - 1] + gaps2[j - 1];
+    }
+
+    // Fill the DP table row by row
+    for (size_t i = 1; i <= len1; ++i) {
+        levenshtein_next_row(prev, curr, symbols1[i - 1], gaps1[i - 1], symbols2, gaps2, costs);
+        std::swap(prev, curr);
+    }
+
+    if (prev != last_row.data()) {
+        std::copy(prev, prev + len2 + 1, last_row.data());
+    }
+}
+
+/**
+ * Last row of the weighted Levenshtein DP, from the kernel chosen for this CPU (see distance_kernels.hpp) for long sequences, from levenshtein_last_row_scalar() otherwise.
+ *
+ * @param symbols1 (span<const PhonemeId>): interned phonemes, rows
+ * @param symbols2 (span<const PhonemeId>): interned phonemes, columns
+ * @param gaps1 (span<const int>): gap_penalties(symbols1)
+ * @param gaps2 (span<const int>): gap_penalties(symbols2)
+ * @param costs (PhonemeCostTable): substitution scores
+ * @param last_row (span<int>): output, symbols2.size() + 1 cells
+ */
+inline void levenshtein_last_row(std::span<const PhonemeId> symbols1, std::span<const PhonemeId> symbols2,
+                                 std::span<const int> gaps1, std::span<const int> gaps2,
+                                 const PhonemeCostTable& costs, std::span<int> last_row) {
+    const std::size_t shorter{std::min(symbols1.size(), symbols2.size())};
+    if (shorter >= SIMD_MIN_LENGTH) {
+        static const LastRowKernel short_kernel{last_row_kernel(kernel_isa(SIMD_MIN_LENGTH))};
+        static const LastRowKernel long_kernel{last_row_kernel(kernel_isa(AVX512_MIN_LENGTH))};
+        if (const LastRowKernel kernel{shorter < AVX512_MIN_LENGTH ? short_kernel : long_kernel}) {
+            kernel(symbols1, symbols2, gaps1, gaps2, costs, last_row);
+            return;
+        }
+    }
+    levenshtein_last_row_scalar(symbols1, symbols2, gaps1, gaps2, costs, last_row);
+}
 
 /**
  * Implementation of Levenshtein distance algorithm, but comparing ARPABET symbols, instead of characters, using custom weights for gaps and substitutions based on phoneme distance.
@@ -15,72 +116,649 @@
  * TODO: This should probably use Damerau distance, i.e. include transposition of adjacent elements in addition to insertions, deletions, and mismatches, because "most" and "moats" are more similar than the double sub penalty would seem?
  *
  *
- * @param phones1 (string): string of space-separated phones
- * @param phones2 (stinrg): string of space-separated phones
- * @return (int): levenshtein distance between the sets of phones
+ * @param symbols1 (span<const PhonemeId>): interned phonemes
+ * @param symbols2 (span<const PhonemeId>): interned phonemes
+ * @return (int): levenshtein distance between the sequences of phonemes
  */
-inline int levenshtein_distance(const std::string& phones1, const std::string& phones2) {
+inline int levenshtein_distance(std::span<const PhonemeId> symbols1, std::span<const PhonemeId> symbols2) {
+    const PhonemeCostTable& costs{phoneme_cost_table()};
 
-    std::vector<std::string> symbols1{phones_string_to_vector(phones1)};
-    std::vector<std::string> symbols2{phones_string_to_vector(phones2)};
+    // Gap penalties per position, including repeated consonants, and the last row, in one scratch buffer
+    struct DistanceScratch;
+    const std::span<int> scratch{scratch_buffer<int, DistanceScratch>(symbols1.size() + 2 * symbols2.size() + 1)};
+    const std::span<int> gaps1{scratch.first(symbols1.size())};
+    const std::span<int> gaps2{scratch.subspan(symbols1.size(), symbols2.size())};
+    const std::span<int> last_row{scratch.subspan(symbols1.size() + symbols2.size())};
+    gap_penalties(symbols1, gaps1);
+    gap_penalties(symbols2, gaps2);
 
-   // Handle empty cases
-    if (symbols1.empty() || symbols2.empty()) {
-      if (symbols1.empty() && symbols2.empty()) {
-        return 0;
-      }
-      else if (symbols1.empty()) {
-         int distance{0};
-         for (const auto& symbol : symbols2) {
-            distance += GAP_PENALTY(symbol);
-         }
-         return distance;
-      }
-      else {
-         int distance{0};
-         for (const auto& symbol : symbols1) {
-            distance += GAP_PENALTY(symbol);
-         }
-         return distance;
-      }
+    levenshtein_last_row(symbols1, symbols2, gaps1, gaps2, costs, last_row);
+    return last_row.back();
+}
+
+/**
+ * Scalar fill of one block of a larger weighted Levenshtein DP, from its first row and column. This is the reference the BlockKernels in distance_kernels.hpp are checked against.
+ *
+ * @param symbols1 (span<const PhonemeId>): interned phonemes, the block's rows
+ * @param symbols2 (span<const PhonemeId>): interned phonemes, the block's columns
+ * @param gaps1 (span<const int>): gap penalties of symbols1, as positions of the whole sequence
+ * @param gaps2 (span<const int>): gap penalties of symbols2, as positions of the whole sequence
+ * @param costs (PhonemeCostTable): substitution scores
+ * @param top (span<int>): symbols2.size() + 1 cells, in the row above the block, out its last row
+ * @param left (span<int>): symbols1.size() + 1 cells, in the column left of the block, out its last column. top[0] == left[0], the corner.
+ */
+inline void levenshtein_block_scalar(std::span<const PhonemeId> symbols1, std::span<const PhonemeId> symbols2,
+                                     std::span<const int> gaps1, std::span<const int> gaps2,
+                                     const PhonemeCostTable& costs, std::span<int> top, std::span<int> left) {
+    const size_t len1 = symbols1.size();
+    const size_t len2 = symbols2.size();
+    // D(0, len2), the first cell of the last column, before top is overwritten
+    const int corner{top[len2]};
+
+    // top is the working row
+    for (size_t i = 1; i <= len1; ++i) {
+        const int* substitution_row{costs.substitution_row(symbols1[i - 1])};
+        const int deletion_cost{gaps1[i - 1]};
+        int diagonal{top[0]};
+        int cell{left[i]};
+        top[0] = cell;
+        for (size_t j = 1; j <= len2; ++j) {
+            const int up{top[j]};
+            cell = std::min({
+                up + deletion_cost,
+                cell + gaps2[j - 1],
+                diagonal + substitution_row[symbols2[j - 1]]
+            });
+            top[j] = cell;
+            diagonal = up;
+        }
+        left[i] = cell;
+    }
+    left[0] = corner;
+}
+
+// levenshtein_block_scalar(), or the block kernel chosen for this CPU (see distance_kernels.hpp) for blocks long enough each way
+inline void levenshtein_block(std::span<const PhonemeId> symbols1, std::span<const PhonemeId> symbols2,
+                              std::span<const int> gaps1, std::span<const int> gaps2,
+                              const PhonemeCostTable& costs, std::span<int> top, std::span<int> left) {
+    const std::size_t shorter{std::min(symbols1.size(), symbols2.size())};
+    if (shorter >= SIMD_MIN_LENGTH) {
+        static const BlockKernel short_kernel{block_kernel(kernel_isa(SIMD_MIN_LENGTH))};
+        static const BlockKernel long_kernel{block_kernel(kernel_isa(AVX512_MIN_LENGTH))};
+        if (const BlockKernel kernel{shorter < AVX512_MIN_LENGTH ? short_kernel : long_kernel}) {
+            kernel(symbols1, symbols2, gaps1, gaps2, costs, top, left);
+            return;
+        }
+    }
+    levenshtein_block_scalar(symbols1, symbols2, gaps1, gaps2, costs, top, left);
+}
+
+// Rows and columns of the blocks levenshtein_distance(..., pool) splits the DP into. A block is a million cells, which dwarfs handing it to a thread, and its edges and diagonals are a few KiB, which stay in L1.
+inline constexpr std::size_t LEVENSHTEIN_TILE{1024};
+
+/**
+ * levenshtein_distance() for very long sequences, e.g. whole documents, spread over pool's threads.
+ *
+ * The DP is cut into LEVENSHTEIN_TILE square blocks, and each block only needs the blocks above and to the left of it, so the blocks along an anti-diagonal are filled in parallel, one anti-diagonal after another. Only the blocks' edges are kept: one row across the whole of symbols2, and one column per row of blocks, so memory stays linear.
+ *
+ * Blocks are filled by the same SIMD kernels as levenshtein_distance() (see levenshtein_block()), so one thread is about as fast either way. Sequences too short for at least two blocks each way, or a pool of one thread, go to levenshtein_distance().
+ *
+ * @param symbols1 (span<const PhonemeId>): interned phonemes
+ * @param symbols2 (span<const PhonemeId>): interned phonemes
+ * @param pool (Task_Pool): threads to fill blocks on
+ * @return (int): levenshtein distance between the sequences of phonemes, the same as levenshtein_distance()
+ */
+inline int levenshtein_distance(std::span<const PhonemeId> symbols1, std::span<const PhonemeId> symbols2, Task_Pool& pool) {
+    const size_t len1 = symbols1.size();
+    const size_t len2 = symbols2.size();
+    const size_t block_rows = (len1 + LEVENSHTEIN_TILE - 1) / LEVENSHTEIN_TILE;
+    const size_t block_cols = (len2 + LEVENSHTEIN_TILE - 1) / LEVENSHTEIN_TILE;
+    if (pool.size() == 1 || block_rows < 2 || block_cols < 2) {
+        return levenshtein_distance(symbols1, symbols2);
+    }
+
+    const PhonemeCostTable& costs{phoneme_cost_table()};
+    const std::vector<int> gaps1{gap_penalties(symbols1)};
+    const std::vector<int> gaps2{gap_penalties(symbols2)};
+
+    // Bottom edge of the lowest block filled so far in each column, starting from the base row
+    std::vector<int> row_edge(len2 + 1, 0);
+    for (size_t j = 1; j <= len2; ++j) {
+        row_edge[j] = row_edge[j - 1] + gaps2[j - 1];
+    }
+    // Right edge of the last block filled so far in each row of blocks, corner included, starting from the base column.
+    // Row of blocks b has rows [b * LEVENSHTEIN_TILE, end] at column_edges[b * LEVENSHTEIN_TILE + b, end + b]
+    std::vector<int> column_edges(len1 + block_rows, 0);
+    const auto column_edge = [&](size_t block_row) {
+        const size_t begin = block_row * LEVENSHTEIN_TILE;
+        const size_t end = std::min(len1, begin + LEVENSHTEIN_TILE);
+        return std::span<int>{column_edges}.subspan(begin + block_row, end - begin + 1);
+    };
+    for (size_t b = 0; b < block_rows; ++b) {
+        const std::span<int> edge{column_edge(b)};
+        edge[0] = b == 0 ? 0 : column_edge(b - 1).back();
+        for (size_t i = 1; i < edge.size(); ++i) {
+            edge[i] = edge[i - 1] + gaps1[b * LEVENSHTEIN_TILE + i - 1];
+        }
     }
 
+    // Blocks on one anti-diagonal touch disjoint stretches of both edges. A block takes its corner from its column edge, since row_edge[col_begin] belongs to the block below and to the left, which may be running, so it works on copies.
+    for (size_t diagonal = 0; diagonal < block_rows + block_cols - 1; ++diagonal) {
+        const size_t first_row = diagonal < block_cols ? 0 : diagonal - block_cols + 1;
+        const size_t last_row = std::min(diagonal, block_rows - 1);
+        pool.parallel_for(first_row, last_row + 1, [&](size_t block_row) {
+            const size_t row_begin = block_row * LEVENSHTEIN_TILE;
+            const size_t col_begin = (diagonal - block_row) * LEVENSHTEIN_TILE;
+            const size_t height = std::min(len1, row_begin + LEVENSHTEIN_TILE) - row_begin;
+            const size_t width = std::min(len2, col_begin + LEVENSHTEIN_TILE) - col_begin;
+            const std::span<int> column{column_edge(block_row)};
+
+            struct BlockEdgeScratch;
+            const std::span<int> edges{scratch_buffer<int, BlockEdgeScratch>(width + height + 2)};
+            const std::span<int> top{edges.first(width + 1)};
+            const std::span<int> left{edges.subspan(width + 1)};
+            top[0] = column[0];
+            std::copy(row_edge.begin() + col_begin + 1, row_edge.begin() + col_begin + width + 1, top.begin() + 1);
+            std::copy(column.begin(), column.end(), left.begin());
+
+            levenshtein_block(symbols1.subspan(row_begin, height), symbols2.subspan(col_begin, width),
+                              std::span<const int>{gaps1}.subspan(row_begin, height), std::span<const int>{gaps2}.subspan(col_begin, width),
+                              costs, top, left);
+
+            std::copy(top.begin() + 1, top.end(), row_edge.begin() + col_begin + 1);
+            std::copy(left.begin(), left.end(), column.begin());
+        });
+    }
+    return row_edge.back();
+}
+
+/**
+ * Last row of the weighted Levenshtein DP, giving up on cells that are further apart than max_distance.
+ *
+ * Costs are never negative, so a cell over max_distance can't lead to a distance under it. Each row only fills the columns reachable from a cell still under the bound in the row above (plus insertions along the row), and once a row has none left we stop.
+ *
+ * @param symbols1 (span<const PhonemeId>): interned phonemes, rows
+ * @param symbols2 (span<const PhonemeId>): interned phonemes, columns
+ * @param gaps1 (span<const int>): gap_penalties(symbols1)
+ * @param gaps2 (span<const int>): gap_penalties(symbols2)
+ * @param costs (PhonemeCostTable): substitution scores
+ * @param max_distance (int): largest distance we care about
+ * @param last_row (span<int>): output, symbols2.size() + 1 cells, those over max_distance are DISTANCE_OVER_BOUND
+ */
+inline void levenshtein_last_row_bounded(std::span<const PhonemeId> symbols1, std::span<const PhonemeId> symbols2,
+                                         std::span<const int> gaps1, std::span<const int> gaps2,
+                                         const PhonemeCostTable& costs, int max_distance, std::span<int> last_row) {
     size_t len1 = symbols1.size();
     size_t len2 = symbols2.size();
 
-    // Create two rows for dynamic programming
-    std::vector<int> prev(len2 + 1, 0);
-    std::vector<int> curr(len2 + 1, 0);
+    std::fill(last_row.begin(), last_row.end(), DISTANCE_OVER_BOUND);
+    if (max_distance < 0) {
+        return;
+    }
+
+    // Every dead cell is stored as just over the bound, which keeps sums from overflowing
+    max_distance = std::min(max_distance, DISTANCE_OVER_BOUND / 2);
+    const int over{max_distance + 1};
 
-    // Initialize base cases with GAP_PENALTY()
+    struct RowsScratch;
+    const std::span<int> rows{scratch_buffer<int, RowsScratch>(2 * (len2 + 1))};
+    std::fill(rows.begin(), rows.end(), over);
+    int* prev = rows.data();
+    int* curr = rows.data() + len2 + 1;
+
+    // Columns [lo, hi] of prev may be under the bound, anything outside is dead
+    size_t lo = 0;
+    size_t hi = 0;
+
+    // Base row, running sums of the gap penalties, up to the last column under the bound
     prev[0] = 0;
-    for (size_t j = 1; j <= len2; ++j) {
-      prev[j] = j * GAP_PENALTY(symbols2.at(j-1));
+    for (size_t j = 1; j <= len2 && prev[j - 1] + gaps2[j - 1] <= max_distance; ++j) {
+        prev[j] = prev[j - 1] + gaps2[j - 1];
+        hi = j;
     }
 
-    // Fill the DP table row by row
     for (size_t i = 1; i <= len1; ++i) {
-        // Base case, other axis
-        curr[0] = i * GAP_PENALTY(symbols1.at(i-1));
-        for (size_t j = 1; j <= len2; ++j) {
-            // std::cout << "Comparing: " << symbols1[i-1];
-            // std::cout << " and " << symbols2[j-1] << std::endl;
+        const int* substitution_row{costs.substitution_row(symbols1[i - 1])};
+        const int deletion_cost{gaps1[i - 1]};
+        bool live{false};
+        size_t row_lo = 0;
+        size_t row_hi = 0;
 
-            // std::cout << "deletion penalty: " << GAP_PENALTY(symbols1.at(i-1), symbols2, j-1) << std::endl;
-            // std::cout << "insertion penalty: " << GAP_PENALTY(symbols2.at(j-1), symbols1, i-1) << std::endl;
+        // curr[lo - 1] only depends on dead cells
+        int left{over};
+        for (size_t j = lo; j <= len2; ++j) {
+            // Past hi + 1 only insertions along this row can still be under the bound
+            if (j > hi + 1 && left > max_distance) {
+                break;
+            }
+            int cell = (j <= hi) ? prev[j] + deletion_cost : over;
+            if (j > 0) {
+                cell = std::min(cell, left + gaps2[j - 1]);
+                if (j - 1 >= lo && j - 1 <= hi) {
+                    cell = std::min(cell, prev[j - 1] + substitution_row[symbols2[j - 1]]);
+                }
+            }
+            cell = std::min(cell, over);
+            curr[j] = cell;
+            left = cell;
 
-            int substitution_score{SUBSTITUTION_SCORE(symbols1[i-1], symbols2[j-1])};
+            if (cell <= max_distance) {
+                if (!live) {
+                    row_lo = j;
+                    live = true;
+                }
+                row_hi = j;
+            }
+        }
 
-            curr[j] = std::min({
-                prev[j] + GAP_PENALTY(symbols1.at(i-1), i > 1 ? symbols1.at(i-2) : ""),      // Deletion of symbol from phones1
-                curr[j - 1] + GAP_PENALTY(symbols2.at(j-1), j > 1 ? symbols2.at(j-2) : ""),  // Insertion of symbol from phones2
-               prev[j - 1] + substitution_score // Substitution
-            });
+        if (!live) {
+            return;
+        }
+        std::swap(prev, curr);
+        lo = row_lo;
+        hi = row_hi;
+    }
+
+    for (size_t j = lo; j <= hi; ++j) {
+        if (prev[j] <= max_distance) {
+            last_row[j] = prev[j];
+        }
+    }
+}
+
+// levenshtein_last_row_bounded(), returning a new last row
+inline std::vector<int> levenshtein_last_row_bounded(std::span<const PhonemeId> symbols1, std::span<const PhonemeId> symbols2,
+                                                     std::span<const int> gaps1, std::span<const int> gaps2,
+                                                     const PhonemeCostTable& costs, int max_distance) {
+    std::vector<int> last_row(symbols2.size() + 1);
+    levenshtein_last_row_bounded(symbols1, symbols2, gaps1, gaps2, costs, max_distance, last_row);
+    return last_row;
+}
+
+/**
+ * levenshtein_distance(), but only if it is at most max_distance, for when we only need to know whether a pair is within a threshold, or better than the best pair so far.
+ *
+ * Far-apart pairs usually stop after a few rows, see levenshtein_last_row_bounded().
+ *
+ * @param symbols1 (span<const PhonemeId>): interned phonemes
+ * @param symbols2 (span<const PhonemeId>): interned phonemes
+ * @param max_distance (int): largest distance we care about
+ * @return (int): levenshtein distance between the sequences of phonemes, or DISTANCE_OVER_BOUND if it is over max_distance
+ */
+inline int levenshtein_distance(std::span<const PhonemeId> symbols1, std::span<const PhonemeId> symbols2, int max_distance) {
+    struct BoundedDistanceScratch;
+    const std::span<int> scratch{scratch_buffer<int, BoundedDistanceScratch>(symbols1.size() + 2 * symbols2.size() + 1)};
+    const std::span<int> gaps1{scratch.first(symbols1.size())};
+    const std::span<int> gaps2{scratch.subspan(symbols1.size(), symbols2.size())};
+    const std::span<int> last_row{scratch.subspan(symbols1.size() + symbols2.size())};
+    gap_penalties(symbols1, gaps1);
+    gap_penalties(symbols2, gaps2);
+
+    levenshtein_last_row_bounded(symbols1, symbols2, gaps1, gaps2, phoneme_cost_table(), max_distance, last_row);
+    return last_row.back();
+}
+
+/**
+ * What a sequence of phonemes is made of, regardless of order, for levenshtein_lower_bound(). Built once per sequence, so bounding a pair is a pass over two small arrays rather than a DP.
+*/
+struct Phoneme_Profile {
+    // how often each phoneme occurs, stopping at 255, which can only lower the bound
+    std::array<std::uint8_t, PHONEME::COUNT> counts{};
+    int vowels{};
+    int consonants{};
+    // consonants that repeat the one before, whose gap penalty is CONSONANT::REPEATED_CONSONANT_PENALTY
+    int repeated_consonants{};
+
+    Phoneme_Profile() = default;
 
-            // std::cout << "Minimum: " << curr[j] << std::endl << std::endl << std::endl;
+    explicit Phoneme_Profile(std::span<const PhonemeId> sequence) {
+        for (std::size_t i{}; i < sequence.size(); ++i) {
+            const PhonemeId phoneme{sequence[i]};
+            if (counts[phoneme] < std::numeric_limits<std::uint8_t>::max()) {
+                ++counts[phoneme];
+            }
+            if (is_vowel(phoneme)) {
+                ++vowels;
+            }
+            else {
+                ++consonants;
+                if (i > 0 && phoneme == sequence[i-1]) {
+                    ++repeated_consonants;
+                }
+            }
         }
-        prev.swap(curr);
     }
+};
 
-    return prev[len2];
+// Twice the least a phoneme left unmatched costs, for levenshtein_lower_bound(): the cheaper of its gap penalty and half its nearest substitution, consonants taken at their cheapest gap penalty, as repeats.
+inline const std::array<int, PHONEME::COUNT>& unmatched_phoneme_charges() {
+    static const std::array<int, PHONEME::COUNT> charges{[] {
+        const PhonemeCostTable& costs{phoneme_cost_table()};
+        std::array<int, PHONEME::COUNT> table{};
+        for (std::size_t i{}; i < PHONEME::COUNT; ++i) {
+            const auto phoneme{static_cast<PhonemeId>(i)};
+            table[i] = std::min(costs.nearest[i], 2 * (is_vowel(phoneme) ? CONSTANTS::VOWEL::INDEL_PENALTY : CONSTANTS::CONSONANT::REPEATED_CONSONANT_PENALTY));
+        }
+        return table;
+    }()};
+    return charges;
+}
+
+/**
+ * Lower bound on levenshtein_distance() of two sequences, from their Phoneme_Profiles alone, so pairs that can't beat the best so far are skipped without running the DP. Never more than the distance.
+ *
+ * The larger of two bounds:
+ * - counts: each vowel not aligned with a vowel costs at least VOWEL::INDEL_PENALTY (a substitution by a consonant costs more), and each consonant not aligned with a consonant at least its gap penalty. This covers the difference in lengths too, as every extra phoneme is one or the other.
+ * - multisets: each phoneme one sequence has more of than the other isn't matched with itself, so it is deleted, inserted, or substituted. One substitution covers one phoneme of each sequence, so each is charged half of unmatched_phoneme_charges().
+ *
+ * @param profile1 (Phoneme_Profile): of one sequence
+ * @param profile2 (Phoneme_Profile): of the other
+ * @return (int): at most levenshtein_distance() of the two sequences
+ */
+inline int levenshtein_lower_bound(const Phoneme_Profile& profile1, const Phoneme_Profile& profile2) {
+    const int vowel_excess{std::abs(profile1.vowels - profile2.vowels)};
+    const int consonant_excess{std::abs(profile1.consonants - profile2.consonants)};
+    const int repeats{std::min(consonant_excess, (profile1.consonants >= profile2.consonants ? profile1 : profile2).repeated_consonants)};
+    const long long count_bound{static_cast<long long>(vowel_excess) * CONSTANTS::VOWEL::INDEL_PENALTY
+                              + static_cast<long long>(repeats) * CONSTANTS::CONSONANT::REPEATED_CONSONANT_PENALTY
+                              + static_cast<long long>(consonant_excess - repeats) * CONSTANTS::CONSONANT::INDEL_PENALTY};
+
+    // max - min rather than abs, which baseline x86-64 can't vectorize
+    const std::array<int, PHONEME::COUNT>& charge{unmatched_phoneme_charges()};
+    int charges{};
+    for (std::size_t i{}; i < PHONEME::COUNT; ++i) {
+        const std::uint8_t excess = std::max(profile1.counts[i], profile2.counts[i]) - std::min(profile1.counts[i], profile2.counts[i]);
+        charges += excess * charge[i];
+    }
+
+    return static_cast<int>(std::min<long long>(std::max<long long>(count_bound, (charges + 1) / 2), DISTANCE_OVER_BOUND));
+}
+
+/**
+ * How well two line ends rhyme: levenshtein_distance() of the whole of both, anchored at their ends, where everything before the two rhymes costs nothing to drop, see end_rhyme_gap_penalties().
+ *
+ * One DP per pair of pronunciations, rather than cutting each one's rhyming part out first and aligning those.
+ *
+ * @param symbols1 (span<const PhonemeId>): interned phonemes of one line end
+ * @param symbols2 (span<const PhonemeId>): interned phonemes of the other
+ * @param max_distance (int): largest distance we care about, DISTANCE_OVER_BOUND for no bound
+ * @return (int): distance between the rhymes, or DISTANCE_OVER_BOUND if it is over max_distance
+ */
+inline int end_rhyme_distance(std::span<const PhonemeId> symbols1, std::span<const PhonemeId> symbols2, int max_distance = DISTANCE_OVER_BOUND) {
+    struct EndRhymeScratch;
+    const std::span<int> scratch{scratch_buffer<int, EndRhymeScratch>(symbols1.size() + 2 * symbols2.size() + 1)};
+    const std::span<int> gaps1{scratch.first(symbols1.size())};
+    const std::span<int> gaps2{scratch.subspan(symbols1.size(), symbols2.size())};
+    const std::span<int> last_row{scratch.subspan(symbols1.size() + symbols2.size())};
+    end_rhyme_gap_penalties(symbols1, symbols2, gaps1, gaps2);
+
+    if (max_distance < DISTANCE_OVER_BOUND) {
+        levenshtein_last_row_bounded(symbols1, symbols2, gaps1, gaps2, phoneme_cost_table(), max_distance, last_row);
+    }
+    else {
+        levenshtein_last_row(symbols1, symbols2, gaps1, gaps2, phoneme_cost_table(), last_row);
+    }
+    return last_row.back();
+}
+
+/**
+ * levenshtein_distance() against a fixed reference, for a sequence that grows and shrinks at its end, e.g. a line being typed.
+ *
+ * Keeps one DP row per phoneme of the sequence, as a stack, so appending k phonemes fills k rows of reference.size() + 1 cells, rolling back pops rows, and nothing already filled is ever refilled. The rows are the same ones levenshtein_last_row_scalar() fills, so distance() is always levenshtein_distance(sequence(), reference).
+ *
+ * USAGE:
+ *
+ * Incremental_Levenshtein comparator{reference};
+ * comparator.append(first_word);
+ * comparator.distance();
+ * comparator.pop_back(first_word.size());
+*/
+class Incremental_Levenshtein {
+public:
+    /**
+     * @param reference (span<const PhonemeId>): interned phonemes to compare against, copied
+    */
+    explicit Incremental_Levenshtein(std::span<const PhonemeId> reference)
+        : reference_{reference.begin(), reference.end()}, reference_gaps_{gap_penalties(reference)}, rows_(reference.size() + 1)
+    {
+        // Row for the empty sequence, running sums of the reference's gap penalties
+        for (std::size_t j = 1; j <= reference_.size(); ++j) {
+            rows_[j] = rows_[j - 1] + reference_gaps_[j - 1];
+        }
+    }
+
+    // Extends the sequence by one phoneme, filling one row
+    void push_back(PhonemeId phoneme) {
+        const std::size_t width{reference_.size() + 1};
+        const int deletion_cost{phoneme_cost_table().gap_penalty(phoneme, sequence_.empty() ? PHONEME::GAP : sequence_.back())};
+        sequence_.push_back(phoneme);
+        rows_.resize(rows_.size() + width);
+        const int* prev{rows_.data() + rows_.size() - 2 * width};
+        levenshtein_next_row(prev, rows_.data() + rows_.size() - width, phoneme, deletion_cost, reference_, reference_gaps_, phoneme_cost_table());
+    }
+
+    // Extends the sequence by phonemes, e.g. a word's pronunciation
+    void append(std::span<const PhonemeId> phonemes) {
+        rows_.reserve(rows_.size() + phonemes.size() * (reference_.size() + 1));
+        for (const PhonemeId phoneme : phonemes) {
+            push_back(phoneme);
+        }
+    }
+
+    // Rolls back the last count phonemes, or all of them if there are fewer
+    void pop_back(std::size_t count = 1) {
+        count = std::min(count, sequence_.size());
+        sequence_.resize(sequence_.size() - count);
+        rows_.resize((sequence_.size() + 1) * (reference_.size() + 1));
+    }
+
+    // levenshtein_distance(sequence(), reference())
+    int distance() const { return rows_.back(); }
+
+    // Last row of the DP, last_row()[j] is the distance from sequence() to the first j phonemes of reference()
+    std::span<const int> last_row() const { return std::span<const int>{rows_}.last(reference_.size() + 1); }
+
+    std::span<const PhonemeId> sequence() const { return sequence_; }
+    std::span<const PhonemeId> reference() const { return reference_; }
+    std::size_t size() const { return sequence_.size(); }
+
+private:
+    PhonemeSequence reference_{};
+    std::vector<int> reference_gaps_{};
+    PhonemeSequence sequence_{};
+    // Row i, for the first i phonemes of sequence_, is rows_[i * (reference_.size() + 1), (i + 1) * (reference_.size() + 1))
+    std::vector<int> rows_{};
+};
+
+/**
+ * Band of a banded DP: the diagonals j - i it fills, from the one through (0, 0) to the one through (len1, len2), and band more on either side.
+ *
+ * Leaving the band and coming back to (len1, len2) takes at least |len2 - len1| + 2 * (band + 1) insertions and deletions, which is what makes a banded result provably optimal, see band_escape_cost().
+ */
+struct Band {
+    std::ptrdiff_t lowest{};    // lowest diagonal j - i filled
+    std::ptrdiff_t highest{};   // highest diagonal j - i filled
+    bool covers_all{};          // every cell is filled, as in the full DP
+
+    Band(size_t len1, size_t len2, size_t band) {
+        const std::ptrdiff_t difference = static_cast<std::ptrdiff_t>(len2) - static_cast<std::ptrdiff_t>(len1);
+        const std::ptrdiff_t width = static_cast<std::ptrdiff_t>(std::min(band, len1 + len2));
+        lowest = std::min<std::ptrdiff_t>(0, difference) - width;
+        highest = std::max<std::ptrdiff_t>(0, difference) + width;
+        covers_all = lowest <= -static_cast<std::ptrdiff_t>(len1) && highest >= static_cast<std::ptrdiff_t>(len2);
+    }
+
+    // Columns [first, last] of row i are in the band
+    size_t first(size_t i) const { return static_cast<size_t>(std::max<std::ptrdiff_t>(0, static_cast<std::ptrdiff_t>(i) + lowest)); }
+    size_t last(size_t i, size_t len2) const { return static_cast<size_t>(std::min<std::ptrdiff_t>(static_cast<std::ptrdiff_t>(len2), static_cast<std::ptrdiff_t>(i) + highest)); }
+};
+
+/**
+ * Least an alignment that leaves a band can cost: the insertions and deletions it needs, at the cheapest gap penalty of either sequence.
+ *
+ * @param len1 (size_t): length of one sequence
+ * @param len2 (size_t): length of the other
+ * @param band (size_t): diagonals on either side, see Band
+ * @param min_gap (int): smallest gap penalty of either sequence
+ * @return (long long): lower bound on the cost of any alignment outside the band
+ */
+inline long long band_escape_cost(size_t len1, size_t len2, size_t band, int min_gap) {
+    const size_t difference = len1 > len2 ? len1 - len2 : len2 - len1;
+    return static_cast<long long>(difference + 2 * (band + 1)) * min_gap;
+}
+
+// Smallest gap penalty of either sequence, DISTANCE_OVER_BOUND if both are empty
+inline int min_gap_penalty(std::span<const int> gaps1, std::span<const int> gaps2) {
+    int min_gap = DISTANCE_OVER_BOUND;
+    for (const int gap : gaps1) min_gap = std::min(min_gap, gap);
+    for (const int gap : gaps2) min_gap = std::min(min_gap, gap);
+    return min_gap;
+}
+
+/**
+ * Narrowest band that every alignment costing at most max_distance fits in, so levenshtein_distance_banded() with it is exact whenever the distance is at most max_distance.
+ *
+ * @param gaps1 (span<const int>): gap_penalties() of one sequence
+ * @param gaps2 (span<const int>): gap_penalties() of the other
+ * @param max_distance (int): largest distance we care about
+ * @return (size_t): band to pass to levenshtein_distance_banded(), wide enough to cover the whole DP when a gap is free
+ */
+inline size_t band_for_max_distance(std::span<const int> gaps1, std::span<const int> gaps2, int max_distance) {
+    const size_t len1 = gaps1.size();
+    const size_t len2 = gaps2.size();
+    const int min_gap = min_gap_penalty(gaps1, gaps2);
+    if (min_gap <= 0 || max_distance < 0) {
+        return min_gap <= 0 ? len1 + len2 : 0;
+    }
+
+    // Smallest band with (difference + 2 * (band + 1)) * min_gap > max_distance
+    const size_t difference = len1 > len2 ? len1 - len2 : len2 - len1;
+    const size_t gaps_affordable = static_cast<size_t>(max_distance / min_gap);
+    if (gaps_affordable <= difference) {
+        return 0;
+    }
+    return std::min((gaps_affordable - difference) / 2, len1 + len2);
+}
+
+// Result of a banded DP, see levenshtein_distance_banded()
+struct Banded_Distance {
+    int distance{};
+    // Whether the distance is the unbanded one: no alignment outside the band can beat it
+    bool optimal{};
+};
+
+/**
+ * levenshtein_distance(), filling only the cells within band diagonals of the corner to corner diagonal, in O(len1 * band) rather than O(len1 * len2).
+ *
+ * Lines being compared are usually about as long as each other, and their good alignments stay near the diagonal. The banded distance is always the cost of some alignment, so never less than the real distance, and it is the real distance whenever nothing outside the band could beat it, which is reported as optimal (see band_escape_cost()).
+ *
+ * To decide whether a pair is within a threshold, use band_for_max_distance(): with that band every distance up to the threshold comes back exact.
+ *
+ * @param symbols1 (span<const PhonemeId>): interned phonemes
+ * @param symbols2 (span<const PhonemeId>): interned phonemes
+ * @param band (size_t): diagonals to fill on either side, beyond the difference in lengths
+ * @return (Banded_Distance): the banded distance, and whether it is provably the real one
+ */
+inline Banded_Distance levenshtein_distance_banded(std::span<const PhonemeId> symbols1, std::span<const PhonemeId> symbols2, size_t band) {
+    const size_t len1 = symbols1.size();
+    const size_t len2 = symbols2.size();
+    const PhonemeCostTable& costs{phoneme_cost_table()};
+    const Band bounds{len1, len2, band};
+
+    struct BandedScratch;
+    const std::span<int> scratch{scratch_buffer<int, BandedScratch>(len1 + len2 + 2 * (len2 + 1))};
+    const std::span<int> gaps1{scratch.first(len1)};
+    const std::span<int> gaps2{scratch.subspan(len1, len2)};
+    gap_penalties(symbols1, gaps1);
+    gap_penalties(symbols2, gaps2);
+    int* prev = scratch.data() + len1 + len2;
+    int* curr = prev + len2 + 1;
+
+    // Cells outside the band are never written, only the ones just past either end of it are read, and those are set to outside
+    constexpr int outside{DISTANCE_OVER_BOUND / 2};
+    prev[0] = 0;
+    for (size_t j = 1; j <= bounds.last(0, len2); ++j) {
+        prev[j] = prev[j - 1] + gaps2[j - 1];
+    }
+    if (bounds.last(0, len2) < len2) {
+        prev[bounds.last(0, len2) + 1] = outside;
+    }
+
+    for (size_t i = 1; i <= len1; ++i) {
+        const size_t first = bounds.first(i);
+        const size_t last = bounds.last(i, len2);
+        const int* substitution_row{costs.substitution_row(symbols1[i - 1])};
+        const int deletion_cost{gaps1[i - 1]};
+
+        int cell{outside};
+        for (size_t j = first; j <= last; ++j) {
+            int best = prev[j] + deletion_cost;
+            if (j > 0) {
+                best = std::min({best, cell + gaps2[j - 1], prev[j - 1] + substitution_row[symbols2[j - 1]]});
+            }
+            cell = std::min(best, outside);
+            curr[j] = cell;
+        }
+        if (last < len2) {
+            curr[last + 1] = outside;
+        }
+        std::swap(prev, curr);
+    }
+
+    const int distance = prev[len2];
+    return Banded_Distance{distance, bounds.covers_all || distance <= band_escape_cost(len1, len2, band, min_gap_penalty(gaps1, gaps2))};
+}
+
+/**
+ * levenshtein_distance() from one query to many candidates.
+ *
+ * When there is a batch kernel for this CPU, candidates are sorted by length first, so that each group of lanes pads as little as possible. Otherwise each candidate goes through levenshtein_last_row_scalar(), still sharing the query's gap penalties.
+ *
+ * @param query (span<const PhonemeId>): interned phonemes
+ * @param candidates (span<const PhonemeSequence>): interned phonemes to compare the query against
+ * @return (vector<int>): distances, in the order of candidates
+ */
+inline std::vector<int> levenshtein_distance_batch(std::span<const PhonemeId> query, std::span<const PhonemeSequence> candidates) {
+    const PhonemeCostTable& costs{phoneme_cost_table()};
+    const std::vector<int> query_gaps{gap_penalties(query)};
+    std::vector<int> distances(candidates.size(), 0);
+
+    static const BatchKernel kernel{batch_kernel(kernel_isa())};
+    if (kernel) {
+        std::vector<std::size_t> order(candidates.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+            return candidates[a].size() < candidates[b].size();
+        });
+
+        std::vector<std::span<const PhonemeId>> sorted(order.size());
+        std::vector<int> sorted_distances(order.size(), 0);
+        for (std::size_t k = 0; k < order.size(); ++k) {
+            sorted[k] = candidates[order[k]];
+        }
+        kernel(query, query_gaps, sorted, sorted_distances, costs);
+        for (std::size_t k = 0; k < order.size(); ++k) {
+            distances[order[k]] = sorted_distances[k];
+        }
+        return distances;
+    }
+
+    std::vector<int> last_row{};
+    for (std::size_t k = 0; k < candidates.size(); ++k) {
+        last_row.assign(candidates[k].size() + 1, 0);
+        levenshtein_last_row(query, candidates[k], query_gaps, gap_penalties(candidates[k]), costs, last_row);
+        distances[k] = last_row.back();
+    }
+    return distances;
+}
+
+/**
+ * String version of levenshtein_distance(), converts the phones to PhonemeIds at the boundary.
+ *
+ * @param phones1 (string_view): string of space-separated phones
+ * @param phones2 (string_view): string of space-separated phones
+ * @return (int): levenshtein distance between the sets of phones
+ */
+inline int levenshtein_distance(std::string_view phones1, std::string_view phones2) {
+    return levenshtein_distance(phones_string_to_ids(phones1), phones_string_to_ids(phones2));
 }
@@ -0,0 +1,181 @@
+#pragma once
+
+#include "convenience.hpp"
+#include "small_vector.hpp"
+
+#include <array>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Compact one-byte representation of CMU Pronouncing Dictionary ARPABET symbols.
+ *
+ * The distance and alignment code compares phonemes in its innermost loops, so instead of comparing strings (and checking std::isdigit(s.back()) to find vowels), every consonant, and every vowel at each of its three stresses, is interned as a PhonemeId.
+ *
+ * Layout:
+ *  0  - 23   consonants, in the order of PHONEME::CONSONANT_SYMBOLS
+ *  24 - 68   vowels, three consecutive ids per vowel (stress 0, 1, 2), in the order of PHONEME::VOWEL_SYMBOLS
+ *
+ * Strings are converted to ids at the API boundary with phoneme_to_id() / phones_string_to_ids(), and back with id_to_phoneme() / ids_to_phones().
+*/
+using PhonemeId = std::uint8_t;
+// Rhyming parts and single words fit inline, whole lines of text spill to the heap
+using PhonemeSequence = SmallVector<PhonemeId, 16>;
+
+namespace PHONEME {
+   inline constexpr std::array<std::string_view, 24> CONSONANT_SYMBOLS{
+      "CH", "JH", "R", "W", "Y", "DH", "F", "HH", "S", "SH", "TH", "V",
+      "Z", "ZH", "L", "M", "N", "NG", "B", "D", "G", "K", "P", "T"
+   };
+
+   // 10 monophthongs followed by the 5 diphthongs.
+   inline constexpr std::array<std::string_view, 15> VOWEL_SYMBOLS{
+      "AE", "AA", "EH", "AH", "AO", "IY", "IH", "UH", "UW", "ER",
+      "AW", "AY", "EY", "OW", "OY"
+   };
+
+   inline constexpr std::size_t CONSONANT_COUNT{CONSONANT_SYMBOLS.size()};
+   inline constexpr std::size_t VOWEL_COUNT{VOWEL_SYMBOLS.size()};
+   inline constexpr std::size_t STRESS_COUNT{3};
+   inline constexpr std::size_t COUNT{CONSONANT_COUNT + VOWEL_COUNT * STRESS_COUNT};
+
+   // Stands in for a gap ("-") in an alignment of PhonemeIds, and for "no previous phoneme". Never a valid phoneme.
+   inline constexpr PhonemeId GAP{0xFF};
+}
+
+constexpr bool is_vowel(PhonemeId id) {
+   return id >= PHONEME::CONSONANT_COUNT && id < PHONEME::COUNT;
+}
+
+// Index into PHONEME::VOWEL_SYMBOLS. Only meaningful for vowels.
+constexpr std::size_t vowel_index(PhonemeId id) {
+   return (id - PHONEME::CONSONANT_COUNT) / PHONEME::STRESS_COUNT;
+}
+
+// CMU stress (0, 1 or 2). Only meaningful for vowels.
+constexpr int vowel_stress(PhonemeId id) {
+   return static_cast<int>((id - PHONEME::CONSONANT_COUNT) % PHONEME::STRESS_COUNT);
+}
+
+constexpr PhonemeId make_vowel_id(std::size_t vowel_index, int stress) {
+   return static_cast<PhonemeId>(PHONEME::CONSONANT_COUNT + vowel_index * PHONEME::STRESS_COUNT + stress);
+}
+
+/**
+ * Interns an ARPABET symbol.
+ *
+ * @param phoneme (string_view): ARPABET symbol, vowels including their stress digit, e.g. "K" or "IY1"
+ * @return (PhonemeId): the interned id
+ * @throws std::out_of_range if the symbol isn't an ARPABET phoneme
+*/
+inline PhonemeId phoneme_to_id(std::string_view phoneme) {
+   if (!phoneme.empty() && std::isdigit(static_cast<unsigned char>(phoneme.back()))) {
+      const int stress{phoneme.back() - '0'};
+      const std::string_view vowel{phoneme.substr(0, phoneme.size() - 1)};
+      for (std::size_t i{}; i < PHONEME::VOWEL_COUNT; ++i) {
+         if (PHONEME::VOWEL_SYMBOLS[i] == vowel && stress < static_cast<int>(PHONEME::STRESS_COUNT)) {
+            return make_vowel_id(i, stress);
+         }
+      }
+   }
+   else {
+      for (std::size_t i{}; i < PHONEME::CONSONANT_COUNT; ++i) {
+         if (PHONEME::CONSONANT_SYMBOLS[i] == phoneme) {
+            return static_cast<PhonemeId>(i);
+         }
+      }
+   }
+   throw std::out_of_range("Phoneme not found");
+}
+
+/**
+ * Converts an interned id back to its ARPABET symbol.
+ *
+ * @param id (PhonemeId): interned phoneme, or PHONEME::GAP
+ * @return (string): ARPABET symbol, or "-" for PHONEME::GAP
+*/
+inline std::string id_to_phoneme(PhonemeId id) {
+   if (id == PHONEME::GAP) {
+      return "-";
+   }
+   if (is_vowel(id)) {
+      std::string vowel{PHONEME::VOWEL_SYMBOLS[vowel_index(id)]};
+      vowel += static_cast<char>('0' + vowel_stress(id));
+      return vowel;
+   }
+   return std::string{PHONEME::CONSONANT_SYMBOLS.at(id)};
+}
+
+/**
+ * Convert vector of separated phoneme symbols to a PhonemeSequence.
+ *
+ * @param phones (vector<string>): vector of phoneme symbols
+ * @return (PhonemeSequence): interned phonemes
+*/
+inline PhonemeSequence phones_to_ids(const std::vector<std::string>& phones) {
+   PhonemeSequence result{};
+   result.reserve(phones.size());
+   for (const auto& phone : phones) {
+      result.emplace_back(phoneme_to_id(phone));
+   }
+   return result;
+}
+
+/**
+ * Interns a CMU style space-separated string of phonemes onto the end of a PhonemeSequence, tokenizing in place (see PhoneTokens).
+ *
+ * @param phones (string_view): string of space-separated phonemes
+ * @param ids (PhonemeSequence): interned phonemes are appended here
+*/
+inline void append_phones_string_ids(std::string_view phones, PhonemeSequence& ids) {
+   for (const std::string_view phone : PhoneTokens{phones}) {
+      ids.emplace_back(phoneme_to_id(phone));
+   }
+}
+
+/**
+ * Convert CMU style space-separated string of phonemes to a PhonemeSequence.
+ *
+ * @param phones (string_view): string of space-separated phonemes
+ * @return (PhonemeSequence): interned phonemes
+*/
+inline PhonemeSequence phones_string_to_ids(std::string_view phones) {
+   PhonemeSequence result{};
+   append_phones_string_ids(phones, result);
+   return result;
+}
+
+/**
+ * Convert a pronunciation of several words, one CMU style string per word, to a single PhonemeSequence, without joining the strings first.
+ *
+ * @param pronunciations (span<const string>): each word's space-separated phonemes
+ * @return (PhonemeSequence): interned phonemes of all the words, in order
+*/
+inline PhonemeSequence pronunciations_to_ids(std::span<const std::string> pronunciations) {
+   PhonemeSequence result{};
+   for (const auto& pronunciation : pronunciations) {
+      append_phones_string_ids(pronunciation, result);
+   }
+   return result;
+}
+
+/**
+ * Convert a PhonemeSequence back to a vector of phoneme symbols.
+ *
+ * @param ids (span<const PhonemeId>): interned phonemes, possibly containing PHONEME::GAP
+ * @return (vector<string>): vector of phoneme symbols, "-" for gaps
+*/
+inline std::vector<std::string> ids_to_phones(std::span<const PhonemeId> ids) {
+   std::vector<std::string> result{};
+   result.reserve(ids.size());
+   for (const auto id : ids) {
+      result.emplace_back(id_to_phoneme(id));
+   }
+   return result;
+}
@@ -0,0 +1,316 @@
+#pragma once
+
+#include "distance.hpp"
+#include "phoneme_id.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <utility>
+#include <vector>
+
+/**
+ * The combinations of one pronunciation per word of a text, one at a time, odometer style: the last word's pronunciation turns fastest.
+ *
+ * Only the current combination is kept, in one buffer. Moving on re-appends the words from the first one whose pronunciation changed, so most steps only rewrite the last word, and memory stays linear in the text however many combinations it has.
+ *
+ * USAGE:
+ *
+ * Pronunciation_Combinations combinations{words};
+ * if (!combinations.empty()) {
+ *     do {
+ *         use(combinations.current());
+ *     } while (combinations.next());
+ * }
+*/
+class Pronunciation_Combinations {
+public:
+    Pronunciation_Combinations() = default;
+
+    /**
+     * @param words (vector<vector<PhonemeSequence>>): each word's pronunciations, in text order
+    */
+    explicit Pronunciation_Combinations(std::vector<std::vector<PhonemeSequence>> words)
+        : words_{std::move(words)}, choices_(words_.size(), 0), word_begin_(words_.size(), 0),
+          empty_{std::any_of(words_.begin(), words_.end(), [](const auto& pronunciations) { return pronunciations.empty(); })}
+    {
+        reset();
+    }
+
+    // Whether some word has no pronunciation, so there are no combinations at all
+    bool empty() const { return empty_; }
+
+    // The current combination, until the next call to next(), reset() or seek()
+    const PhonemeSequence& current() const { return current_; }
+
+    // Which pronunciation of each word current() is made of
+    std::span<const std::size_t> choices() const { return choices_; }
+
+    // Moves on to the next combination, or back to the first and returns false after the last
+    bool next() {
+        for (std::size_t word{words_.size()}; word-- > 0;) {
+            if (++choices_[word] < words_[word].size()) {
+                rebuild_from(word);
+                return true;
+            }
+            choices_[word] = 0;
+        }
+        rebuild_from(0);
+        return false;
+    }
+
+    // Back to the first combination
+    void reset() {
+        std::fill(choices_.begin(), choices_.end(), 0);
+        rebuild_from(0);
+    }
+
+    // To the combination with these choices(), e.g. one kept from an earlier pass
+    void seek(std::span<const std::size_t> choices) {
+        std::copy(choices.begin(), choices.end(), choices_.begin());
+        rebuild_from(0);
+    }
+
+    // Combinations in all, saturating at the largest size_t
+    std::size_t count() const {
+        if (empty_) {
+            return 0;
+        }
+        std::size_t combinations{1};
+        for (const auto& pronunciations : words_) {
+            combinations = combinations > std::numeric_limits<std::size_t>::max() / pronunciations.size() ? std::numeric_limits<std::size_t>::max() : combinations * pronunciations.size();
+        }
+        return combinations;
+    }
+
+private:
+    void rebuild_from(std::size_t first_word) {
+        if (empty_) {
+            current_.clear();
+            return;
+        }
+        current_.resize(first_word < words_.size() ? word_begin_[first_word] : current_.size());
+        for (std::size_t word{first_word}; word < words_.size(); ++word) {
+            word_begin_[word] = current_.size();
+            const auto& pronunciation = words_[word][choices_[word]];
+            current_.insert(current_.end(), pronunciation.begin(), pronunciation.end());
+        }
+    }
+
+    std::vector<std::vector<PhonemeSequence>> words_{};
+    std::vector<std::size_t> choices_{};
+    // Where each word starts in current_
+    std::vector<std::size_t> word_begin_{};
+    bool empty_{};
+    PhonemeSequence current_{};
+};
+
+/**
+ * Every pronunciation of a text at once, as a DAG of phonemes: each word branches into its pronunciations, and they all join again before the next word.
+ *
+ * Node 0 is the start and has no phoneme. Every other node is one phoneme of one pronunciation, and nodes come in text order, so a node's predecessors always come before it. Each path from the start to one of ends() spells one combination of get_text_pronunciation_combinations(), but the lattice only grows with the sum of the words' pronunciations, not their product.
+ *
+ * A phoneme's gap penalty depends on the phoneme before it (see gap_penalties()), which at the start of a word depends on how the word before was said, so it is kept per edge.
+ *
+ * USAGE:
+ *
+ * Pronunciation_Lattice lattice{};
+ * lattice.add_word(pronunciations_of_read);
+ * lattice.add_word(pronunciations_of_the);
+ * lattice_distance(lattice, other_lattice);
+*/
+class Pronunciation_Lattice {
+public:
+    // An edge into a node: the node before it, and the gap penalty of the node's phoneme when it follows that one
+    struct Predecessor {
+        std::uint32_t node;
+        int gap;
+    };
+
+    // Adds a word after the words already added, said any of these ways. Repeated pronunciations are only added once.
+    void add_word(std::span<const PhonemeSequence> pronunciations) {
+        if (pronunciations.empty()) {
+            return;
+        }
+        const std::vector<std::uint32_t> entries{ends_};
+        ends_.clear();
+        const PhonemeCostTable& costs{phoneme_cost_table()};
+
+        std::size_t distinct{};
+        for (std::size_t k{}; k < pronunciations.size(); ++k) {
+            const auto& pronunciation = pronunciations[k];
+            if (std::find(pronunciations.begin(), pronunciations.begin() + k, pronunciation) != pronunciations.begin() + k) {
+                continue;
+            }
+            ++distinct;
+            if (pronunciation.empty()) {
+                for (const std::uint32_t entry : entries) {
+                    add_end(entry);
+                }
+                continue;
+            }
+            for (std::size_t i{}; i < pronunciation.size(); ++i) {
+                const auto node = static_cast<std::uint32_t>(phonemes_.size());
+                const PhonemeId phoneme{pronunciation[i]};
+                if (i == 0) {
+                    for (const std::uint32_t entry : entries) {
+                        predecessors_.push_back(Predecessor{entry, costs.gap_penalty(phoneme, phonemes_[entry])});
+                    }
+                }
+                else {
+                    predecessors_.push_back(Predecessor{node - 1, costs.gap_penalty(phoneme, pronunciation[i - 1])});
+                }
+                phonemes_.push_back(phoneme);
+                predecessor_end_.push_back(static_cast<std::uint32_t>(predecessors_.size()));
+            }
+            add_end(static_cast<std::uint32_t>(phonemes_.size() - 1));
+        }
+
+        // Saturating, so that a very long text still reports "more than one"
+        paths_ = paths_ > std::numeric_limits<std::size_t>::max() / distinct ? std::numeric_limits<std::size_t>::max() : paths_ * distinct;
+    }
+
+    // Nodes, counting the start
+    std::size_t size() const { return phonemes_.size(); }
+
+    // Phoneme of each node, PHONEME::GAP for the start. With single_path(), phonemes().subspan(1) is the text's only pronunciation.
+    std::span<const PhonemeId> phonemes() const { return phonemes_; }
+
+    std::span<const Predecessor> predecessors(std::size_t node) const {
+        return std::span<const Predecessor>{predecessors_}.subspan(predecessor_end_[node], predecessor_end_[node + 1] - predecessor_end_[node]);
+    }
+
+    // Nodes the last word can end on, the start if there are no words
+    std::span<const std::uint32_t> ends() const { return ends_; }
+
+    // Combinations of pronunciations, saturating at the largest size_t
+    std::size_t paths() const { return paths_; }
+    bool single_path() const { return paths_ == 1; }
+
+private:
+    void add_end(std::uint32_t node) {
+        if (std::find(ends_.begin(), ends_.end(), node) == ends_.end()) {
+            ends_.push_back(node);
+        }
+    }
+
+    std::vector<PhonemeId> phonemes_{PHONEME::GAP};
+    // predecessors_[predecessor_end_[node], predecessor_end_[node + 1]) are node's
+    std::vector<std::uint32_t> predecessor_end_{0, 0};
+    std::vector<Predecessor> predecessors_{};
+    std::vector<std::uint32_t> ends_{0};
+    std::size_t paths_{1};
+};
+
+/**
+ * Minimum weighted edit distance between any pronunciation of one text and any pronunciation of the other, with one DP over the two lattices rather than one per pair of combinations.
+ *
+ * The same DP as levenshtein_distance(), except that a cell takes the best of every predecessor of its row's node and of its column's node. Gap penalties come from the edge taken, so each path pair is scored exactly as levenshtein_distance() scores that pair of combinations, and the minimum over cells is the minimum over pairs.
+ *
+ * A row is only kept until the last node that follows it is filled, which for text is the end of the next word, so memory stays at a few rows per pronunciation rather than the whole table.
+ *
+ * @param lattice1 (Pronunciation_Lattice): pronunciations of one text, rows
+ * @param lattice2 (Pronunciation_Lattice): pronunciations of the other, columns
+ * @return (int): the smallest levenshtein_distance() between a path of lattice1 and a path of lattice2
+*/
+inline int lattice_distance(const Pronunciation_Lattice& lattice1, const Pronunciation_Lattice& lattice2) {
+    const PhonemeCostTable& costs{phoneme_cost_table()};
+    const std::size_t n{lattice1.size()};
+    const std::size_t m{lattice2.size()};
+    const std::span<const PhonemeId> phonemes2{lattice2.phonemes()};
+
+    // Assign each row a slot up front, reusing slots of rows nothing later needs, so all rows fit one scratch buffer
+    struct SlotScratch;
+    const std::span<std::uint32_t> slot_scratch{scratch_buffer<std::uint32_t, SlotScratch>(2 * n)};
+    const std::span<std::uint32_t> last_use{slot_scratch.first(n)};
+    const std::span<std::uint32_t> slot_of{slot_scratch.subspan(n)};
+    std::fill(last_use.begin(), last_use.end(), 0);
+    for (std::size_t u{1}; u < n; ++u) {
+        for (const auto& predecessor : lattice1.predecessors(u)) {
+            last_use[predecessor.node] = static_cast<std::uint32_t>(u);
+        }
+    }
+    for (const std::uint32_t end : lattice1.ends()) {
+        last_use[end] = static_cast<std::uint32_t>(n);
+    }
+    std::vector<std::uint32_t> free_slots{};
+    std::uint32_t slots{};
+    for (std::size_t u{}; u < n; ++u) {
+        if (free_slots.empty()) {
+            slot_of[u] = slots++;
+        }
+        else {
+            slot_of[u] = free_slots.back();
+            free_slots.pop_back();
+        }
+        for (const auto& predecessor : lattice1.predecessors(u)) {
+            if (last_use[predecessor.node] == u) {
+                free_slots.push_back(slot_of[predecessor.node]);
+            }
+        }
+    }
+
+    // The slots, then the best of several predecessor rows, for and without their gap penalties
+    struct LatticeRowScratch;
+    const std::span<int> rows{scratch_buffer<int, LatticeRowScratch>((slots + 2) * m)};
+    const auto row = [&](std::size_t node) { return rows.data() + slot_of[node] * m; };
+    int* merged_diagonal{rows.data() + slots * m};
+    int* merged_up{merged_diagonal + m};
+
+    // Fills cur from the row above, where up_at(v) is the best deletion into column v
+    const auto fill = [&](int* cur, const int* diagonal, const int* substitution_row, auto up_at) {
+        cur[0] = up_at(0);
+        for (std::size_t v{1}; v < m; ++v) {
+            int best{up_at(v)};
+            const int substitution{substitution_row[phonemes2[v]]};
+            for (const auto& predecessor : lattice2.predecessors(v)) {
+                best = std::min({best, cur[predecessor.node] + predecessor.gap, diagonal[predecessor.node] + substitution});
+            }
+            cur[v] = best;
+        }
+    };
+
+    // First row, insertions only
+    int* first{row(0)};
+    first[0] = 0;
+    for (std::size_t v{1}; v < m; ++v) {
+        int best{std::numeric_limits<int>::max()};
+        for (const auto& predecessor : lattice2.predecessors(v)) {
+            best = std::min(best, first[predecessor.node] + predecessor.gap);
+        }
+        first[v] = best;
+    }
+
+    for (std::size_t u{1}; u < n; ++u) {
+        const auto predecessors = lattice1.predecessors(u);
+        const int* substitution_row{costs.substitution_row(lattice1.phonemes()[u])};
+        int* cur{row(u)};
+        if (predecessors.size() == 1) {
+            const int* above{row(predecessors[0].node)};
+            const int gap{predecessors[0].gap};
+            fill(cur, above, substitution_row, [above, gap](std::size_t v) { return above[v] + gap; });
+            continue;
+        }
+        // The first phoneme of a pronunciation, after any pronunciation of the word before
+        std::copy_n(row(predecessors[0].node), m, merged_diagonal);
+        std::transform(merged_diagonal, merged_diagonal + m, merged_up, [gap = predecessors[0].gap](int cell) { return cell + gap; });
+        for (const auto& predecessor : predecessors.subspan(1)) {
+            const int* above{row(predecessor.node)};
+            for (std::size_t v{}; v < m; ++v) {
+                merged_diagonal[v] = std::min(merged_diagonal[v], above[v]);
+                merged_up[v] = std::min(merged_up[v], above[v] + predecessor.gap);
+            }
+        }
+        fill(cur, merged_diagonal, substitution_row, [merged_up](std::size_t v) { return merged_up[v]; });
+    }
+
+    int distance{std::numeric_limits<int>::max()};
+    for (const std::uint32_t end1 : lattice1.ends()) {
+        for (const std::uint32_t end2 : lattice2.ends()) {
+            distance = std::min(distance, row(end1)[end2]);
+        }
+    }
+    return distance;
+}
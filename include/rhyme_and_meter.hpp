@@ -4,10 +4,22 @@
 #include "hirschberg.hpp"
 #include "convenience.hpp"
 #include "levenshtein_distance.hpp"
+#include "phoneme_id.hpp"
+#include "pronunciation_lattice.hpp"
+#include "task_pool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
 #include <expected>
-#include <functional>
+#include <limits>
+#include <memory>
+#include <optional>
 #include <set>
+#include <span>
 #include <string>
+#include <type_traits>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -20,11 +32,289 @@ enum class MeterError {
 
 std::string getErrorMessage(MeterError error);
 
+// Results compare_text_pronunciations() can rank by distance alone: an int distance, or an alignment with its distance
+template<typename ResultType>
+concept Distance_Result = std::same_as<ResultType, int> || requires(const ResultType& result) {
+    { result.distance } -> std::convertible_to<int>;
+};
+
+template<Distance_Result ResultType>
+constexpr int result_distance(const ResultType& result) {
+    if constexpr (std::same_as<ResultType, int>) {
+        return result;
+    } else {
+        return result.distance;
+    }
+}
+
+// A result that carries only a distance, to hand to a comparison function as its bound
+template<Distance_Result ResultType>
+ResultType distance_only_result(int distance) {
+    if constexpr (std::same_as<ResultType, int>) {
+        return distance;
+    } else {
+        ResultType result{};
+        result.distance = distance;
+        return result;
+    }
+}
+
+// comparison_funcs that can bound a pair from its Phoneme_Profiles, so compare_text_pronunciations() skips pairs that can't win. The bound must never be more than the distance the call would return.
+template<typename ComparisonFunc>
+concept Lower_Bounded_Comparison = requires(const ComparisonFunc& comparison_func, const Phoneme_Profile& profile) {
+    { comparison_func.lower_bound(profile, profile) } -> std::convertible_to<int>;
+};
+
+// comparison_func for compare_text_pronunciations(): levenshtein_distance(), bounded by the best pair so far, with levenshtein_lower_bound() to skip pairs
+struct Levenshtein_Comparison {
+    int operator()(const PhonemeSequence& pronunciation1, const PhonemeSequence& pronunciation2, const std::optional<int>& minimum) const {
+        return minimum ? levenshtein_distance(pronunciation1, pronunciation2, *minimum - 1) : levenshtein_distance(pronunciation1, pronunciation2);
+    }
+
+    int lower_bound(const Phoneme_Profile& profile1, const Phoneme_Profile& profile2) const {
+        return levenshtein_lower_bound(profile1, profile2);
+    }
+};
+
+//minimum_rhyme_distance() and compare_text_pronunciations() bound pairs first (see levenshtein_lower_bound()) when there are at least this many.
+//Below it the bounds cost about what they save, as the bounded DPs of short rhyming parts already give up early.
+inline constexpr std::size_t LOWER_BOUND_PAIRS{8};
+
+//compare_text_pronunciations() bounds or shares out the combinations of text1 as many at a time as make this many pairs with those of text2, so memory stays linear in the combinations.
+//A block of everyday line pairs takes a few hundred microseconds, long enough that starting a block costs nothing in comparison.
+inline constexpr std::size_t COMBINATION_BLOCK_PAIRS{4096};
+
+//Given threads, compare_text_pronunciations() shares out the pairs of combinations of two texts with at least this many.
+//Below it the pairs of everyday lines take a few microseconds in all, about what handing them to the threads takes.
+inline constexpr std::size_t COMBINATION_PARALLEL_PAIRS{64};
+
+// Default min_func of compare_text_pronunciations(), the smaller distance is less
+struct Smaller_Distance {
+    template<Distance_Result ResultType>
+    constexpr bool operator()(const ResultType& a, const ResultType& b) const {
+        return result_distance(a) < result_distance(b);
+    }
+};
+
 class Rhyme_and_Meter {
 private:
     // CMUDict phonetic class
     Phonetic dict{};
 
+    // Threads for long alignments, see set_alignment_threads(). Empty runs everything on the calling thread.
+    std::unique_ptr<Task_Pool> alignment_pool{};
+
+    // Threads for comparing many pairs of pronunciation combinations, see set_combination_threads(). Empty runs everything on the calling thread.
+    std::unique_ptr<Task_Pool> combination_pool{};
+
+    // The best pair of block_compare_pronunciations(), and which it is
+    template<typename ResultType>
+    struct Best_Pronunciation_Pair {
+        ResultType result;
+        // choices() of its combination of the first text
+        std::vector<std::size_t> choices1;
+        // index of its combination of the second text
+        std::size_t pronunciation2;
+    };
+
+    /**
+     * Weighted edit distance of two text pronunciations, bounded, or filled block by block across alignment_pool for document-length pairs (unbounded, see levenshtein_distance(..., pool)).
+     *
+     * @return (int): the distance, DISTANCE_OVER_BOUND if it is over max_distance
+    */
+    int pronunciation_distance(std::span<const PhonemeId> phones1, std::span<const PhonemeId> phones2, int max_distance) const;
+
+    /**
+     * compare_text_pronunciations() by distance, when its pairs are bounded first (see Lower_Bounded_Comparison) or shared out across threads.
+     *
+     * The combinations of text1 are streamed in blocks, as many as make COMBINATION_BLOCK_PAIRS pairs with every combination of text2 (at least one), so memory stays linear in the combinations of text2 however many text1 has. Each block starts from the best pair of the blocks before it, which every pair of the block comes after, and once that is at distance 0 the rest are skipped.
+     *
+     * Of two pairs at the same distance the earlier one wins, as serially, however the pairs of a block are ordered: a pair earlier than the best is bounded by one more than the best's distance, so it may tie, and a later one by the distance itself.
+     *
+     * @param combinations1 (Pronunciation_Combinations): combinations of the first text, not empty
+     * @param pronunciations2 (vector<PhonemeSequence>): every combination of the second text, not empty, fewer than UINT32_MAX
+     * @param comparison_func (callable): as for compare_text_pronunciations(). The minimum it is given only carries a distance.
+     * @param pool (Task_Pool*): threads to share each block out across (see parallel_compare_block()), or nullptr to compare its pairs in ascending order of bound (see bounded_compare_block())
+     * @return the result of the best pair, and the pair
+    */
+    template<typename ResultType, typename ComparisonFunc>
+    static Best_Pronunciation_Pair<ResultType> block_compare_pronunciations(Pronunciation_Combinations& combinations1, const std::vector<PhonemeSequence>& pronunciations2, ComparisonFunc& comparison_func, Task_Pool* pool) {
+        std::vector<Phoneme_Profile> profiles2{};
+        if constexpr (Lower_Bounded_Comparison<std::remove_cvref_t<ComparisonFunc>>) {
+            profiles2 = std::vector<Phoneme_Profile>(pronunciations2.begin(), pronunciations2.end());
+        }
+
+        const std::size_t block_rows{std::max<std::size_t>(1, COMBINATION_BLOCK_PAIRS / pronunciations2.size())};
+        const std::size_t words1{combinations1.choices().size()};
+        std::vector<PhonemeSequence> rows{};
+        std::vector<std::size_t> row_choices{};
+        rows.reserve(std::min(block_rows, combinations1.count()));
+        std::optional<ResultType> best{};
+        std::vector<std::size_t> best_choices1{};
+        std::size_t best_pronunciation2{};
+        bool more{true};
+        while (more && !(best && result_distance(*best) == 0)) {
+            rows.clear();
+            row_choices.clear();
+            do {
+                rows.push_back(combinations1.current());
+                row_choices.insert(row_choices.end(), combinations1.choices().begin(), combinations1.choices().end());
+                more = combinations1.next();
+            } while (more && rows.size() < block_rows);
+
+            std::optional<std::size_t> winner{};
+            if (pool) {
+                winner = parallel_compare_block(rows, pronunciations2, profiles2, comparison_func, *pool, best);
+            }
+            else if constexpr (Lower_Bounded_Comparison<std::remove_cvref_t<ComparisonFunc>>) {
+                winner = bounded_compare_block(rows, pronunciations2, profiles2, comparison_func, best);
+            }
+            if (winner) {
+                const std::size_t row{*winner / pronunciations2.size()};
+                best_choices1.assign(row_choices.begin() + row * words1, row_choices.begin() + (row + 1) * words1);
+                best_pronunciation2 = *winner % pronunciations2.size();
+            }
+        }
+        return {std::move(*best), std::move(best_choices1), best_pronunciation2};
+    }
+
+    /**
+     * One block of block_compare_pronunciations(), its pairs compared in ascending order of bound, until the rest can't beat the best. The best pair is usually among the first few, and its distance then bounds the rest.
+     *
+     * @param rows (vector<PhonemeSequence>): the block's combinations of the first text
+     * @param pronunciations2 (vector<PhonemeSequence>): every combination of the second text
+     * @param profiles2 (vector<Phoneme_Profile>): of pronunciations2
+     * @param comparison_func (Lower_Bounded_Comparison): as for compare_text_pronunciations()
+     * @param best (optional<ResultType>): the best pair of the blocks before, replaced by this block's if it beats it
+     * @return (optional<size_t>): the index of this block's pair, row * pronunciations2.size() + combination2, if it beat the blocks before
+    */
+    template<typename ResultType, typename ComparisonFunc>
+    static std::optional<std::size_t> bounded_compare_block(const std::vector<PhonemeSequence>& rows, const std::vector<PhonemeSequence>& pronunciations2, const std::vector<Phoneme_Profile>& profiles2,
+                                      ComparisonFunc& comparison_func, std::optional<ResultType>& best) {
+        // bound in the high half, pair index in the low half, so sorting orders by bound and then as serially
+        std::vector<std::uint64_t> pairs{};
+        pairs.reserve(rows.size() * pronunciations2.size());
+        for (std::size_t i{}; i < rows.size(); ++i) {
+            const Phoneme_Profile profile1{rows[i]};
+            for (std::size_t j{}; j < pronunciations2.size(); ++j) {
+                const int lower_bound{comparison_func.lower_bound(profile1, profiles2[j])};
+                pairs.push_back(static_cast<std::uint64_t>(lower_bound) << 32 | (i * pronunciations2.size() + j));
+            }
+        }
+        std::sort(pairs.begin(), pairs.end());
+
+        // this block's pair, once it holds the best; until then the best comes before all of them
+        std::optional<std::size_t> best_pair{};
+        for (const std::uint64_t packed : pairs) {
+            const int lower_bound{static_cast<int>(packed >> 32)};
+            const std::size_t pair{static_cast<std::size_t>(packed & 0xFFFFFFFF)};
+            std::optional<ResultType> bound{};
+            bool earlier{};
+            if (best) {
+                const int distance{result_distance(*best)};
+                if (lower_bound > distance) {
+                    break;
+                }
+                earlier = !best_pair || *best_pair < pair;
+                if (earlier && lower_bound == distance) {
+                    continue;
+                }
+                bound = distance_only_result<ResultType>(earlier ? distance : distance + 1);
+            }
+
+            ResultType result = comparison_func(rows[pair / pronunciations2.size()], pronunciations2[pair % pronunciations2.size()], bound);
+            const int distance{result_distance(result)};
+            if (!best || distance < result_distance(*best) || (distance == result_distance(*best) && !earlier)) {
+                best = std::move(result);
+                best_pair = pair;
+            }
+        }
+        return best_pair;
+    }
+
+    /**
+     * One block of block_compare_pronunciations(), its pairs shared out across pool.
+     *
+     * The best pair so far is one atomic word, its distance in the high half and its place in the low half: 0 for the best of the blocks before, and the pair index (row * pronunciations2.size() + combination2) plus one for this block's. So the smaller word is the better pair, and of two pairs at the same distance the earlier, whatever order the threads get to the pairs in.
+     *
+     * @param rows (vector<PhonemeSequence>): the block's combinations of the first text
+     * @param pronunciations2 (vector<PhonemeSequence>): every combination of the second text
+     * @param profiles2 (vector<Phoneme_Profile>): of pronunciations2 for a Lower_Bounded_Comparison, which skips pairs by their bounds, otherwise empty
+     * @param comparison_func (callable): as for compare_text_pronunciations(), called from several threads at once
+     * @param pool (Task_Pool): threads to share the pairs out across
+     * @param best (optional<ResultType>): the best pair of the blocks before, replaced by this block's if it beats it
+     * @return (optional<size_t>): the index of this block's pair, row * pronunciations2.size() + combination2, if it beat the blocks before
+    */
+    template<typename ResultType, typename ComparisonFunc>
+    static std::optional<std::size_t> parallel_compare_block(const std::vector<PhonemeSequence>& rows, const std::vector<PhonemeSequence>& pronunciations2, const std::vector<Phoneme_Profile>& profiles2,
+                                       ComparisonFunc& comparison_func, Task_Pool& pool, std::optional<ResultType>& best) {
+        constexpr bool lower_bounded{Lower_Bounded_Comparison<std::remove_cvref_t<ComparisonFunc>>};
+        std::vector<Phoneme_Profile> profiles1{};
+        if constexpr (lower_bounded) {
+            profiles1 = std::vector<Phoneme_Profile>(rows.begin(), rows.end());
+        }
+
+        constexpr std::uint64_t NO_PAIR{std::numeric_limits<std::uint64_t>::max()};
+        std::atomic<std::uint64_t> best_packed{best ? static_cast<std::uint64_t>(result_distance(*best)) << 32 : NO_PAIR};
+
+        // More chunks than threads, as chunks that fall behind the best pair finish early
+        const std::size_t pairs{rows.size() * pronunciations2.size()};
+        const std::size_t chunks{std::min(pairs, pool.size() * 8)};
+        std::vector<std::optional<ResultType>> chunk_best(chunks);
+
+        pool.parallel_for(0, chunks, [&](std::size_t chunk) {
+            const std::size_t end{pairs * (chunk + 1) / chunks};
+            for (std::size_t pair{pairs * chunk / chunks}; pair < end; ++pair) {
+                const std::uint64_t place{pair + 1};
+                std::uint64_t shared{best_packed.load(std::memory_order_relaxed)};
+                std::optional<ResultType> bound{};
+                if (shared != NO_PAIR) {
+                    const int distance{static_cast<int>(shared >> 32)};
+                    const bool earlier{(shared & 0xFFFFFFFF) < place};
+                    if (distance == 0 && earlier) {
+                        return;
+                    }
+                    if constexpr (lower_bounded) {
+                        const int lower_bound{comparison_func.lower_bound(profiles1[pair / pronunciations2.size()], profiles2[pair % pronunciations2.size()])};
+                        if (lower_bound > distance || (lower_bound == distance && earlier)) {
+                            continue;
+                        }
+                    }
+                    bound = distance_only_result<ResultType>(earlier ? distance : distance + 1);
+                }
+
+                ResultType result = comparison_func(rows[pair / pronunciations2.size()], pronunciations2[pair % pronunciations2.size()], bound);
+                const std::uint64_t packed{static_cast<std::uint64_t>(result_distance(result)) << 32 | place};
+                while (packed < shared && !best_packed.compare_exchange_weak(shared, packed, std::memory_order_relaxed)) {}
+                if (packed < shared) {
+                    chunk_best[chunk] = std::move(result);
+                }
+            }
+        });
+
+        // The winner was the last pair its chunk kept: any later one would have had to beat it
+        const std::uint64_t place{best_packed.load() & 0xFFFFFFFF};
+        if (place == 0) {
+            return std::nullopt;
+        }
+        const std::size_t winner{static_cast<std::size_t>(place - 1)};
+        std::size_t chunk{winner * chunks / pairs};
+        while (pairs * (chunk + 1) / chunks <= winner) ++chunk;
+        while (pairs * chunk / chunks > winner) --chunk;
+        best = std::move(chunk_best[chunk]);
+        return winner;
+    }
+
+    // Every combination, in order, as the odometer steps through them
+    static std::vector<PhonemeSequence> all_pronunciations(Pronunciation_Combinations& combinations) {
+        std::vector<PhonemeSequence> pronunciations{};
+        pronunciations.reserve(combinations.count());
+        do {
+            pronunciations.push_back(combinations.current());
+        } while (combinations.next());
+        return pronunciations;
+    }
+
 // TODO mark functions as const that don't change state
 
 public:
@@ -119,6 +409,28 @@ public:
      * @return the minimum weighted edit distance
     */
     int minimum_rhyme_distance(const std::pair<std::vector<std::string>, std::vector<std::string>>& pair_of_possible_pronunciations);
+
+    /**
+     * minimum_rhyme_distance() over rhyming parts that are already interned, so callers that keep PhonemeSequences skip the string round trip.
+     * 
+     * With at least LOWER_BOUND_PAIRS pairs, every pair is bounded first (see levenshtein_lower_bound()), and the DP runs on the pairs in ascending order of bound, until the rest can't beat the best.
+     * 
+     * @param pronunciations1 (span<const PhonemeSequence>): possible rhyming parts of one line
+     * @param pronunciations2 (span<const PhonemeSequence>): possible rhyming parts of the other
+     * @return the minimum weighted edit distance, 0 if either side is empty
+    */
+    int minimum_rhyme_distance(std::span<const PhonemeSequence> pronunciations1, std::span<const PhonemeSequence> pronunciations2);
+
+    /**
+     * Scores one rhyming part against many candidates at once, e.g. to rank rhyme suggestions.
+     * 
+     * Uses the same weighted edit distance as minimum_rhyme_distance(), but computes several candidates' DPs side by side (see levenshtein_distance_batch()).
+     * 
+     * @param query (span<const PhonemeId>): rhyming part to score candidates against
+     * @param candidates (span<const PhonemeSequence>): candidate rhyming parts
+     * @return (vector<int>): the weighted edit distance to each candidate, in the order of candidates
+    */
+    std::vector<int> batch_rhyme_distance(std::span<const PhonemeId> query, std::span<const PhonemeSequence> candidates);
     
     /**
      * Helper function that takes a text string and returns all possible pronunciation combinations.
@@ -128,98 +440,117 @@ public:
     */
     std::expected<std::vector<std::vector<std::string>>, UnidentifiedWords> get_text_pronunciation_combinations(const std::string& text);
     
+    /**
+     * Every pronunciation of a text as one Pronunciation_Lattice, which grows with the sum of the words' pronunciations rather than the product get_text_pronunciation_combinations() enumerates.
+     * 
+     * @param text (string): text string to process
+     * @return std::expected containing either the lattice, or an error if any words failed to be identified
+    */
+    std::expected<Pronunciation_Lattice, UnidentifiedWords> get_text_pronunciation_lattice(const std::string& text);
+
+    /**
+     * get_text_pronunciation_combinations() one at a time, interned straight from the per-word pronunciations, so a text with many combinations never has them all in memory.
+     * 
+     * @param text (string): text string to process
+     * @return std::expected containing either the combinations, at the first, or an error if any words failed to be identified
+    */
+    std::expected<Pronunciation_Combinations, UnidentifiedWords> stream_text_pronunciation_combinations(const std::string& text);
+
+    /**
+     * stream_text_pronunciation_combinations() of both texts.
+     * 
+     * @param text1 (string): first text string
+     * @param text2 (string): second text string
+     * @return std::expected containing either the combinations of text1 and of text2, or an error with the unidentified words of both
+    */
+    std::expected<std::pair<Pronunciation_Combinations, Pronunciation_Combinations>, UnidentifiedWords> stream_texts_pronunciation_combinations(const std::string& text1, const std::string& text2);
+    
     /**
      * Generic function that takes two strings of text and applies a comparison function to all possible pronunciation combinations.
      * 
      * This method runs text_to_phones() on each text string, then generates all possible combinations
      * of word pronunciations from both texts and applies the provided comparison function to each combination.
+     * The combinations of text2 are built once, up front, and those of text1 streamed past them, so each combination is built exactly once.
+     * 
+     * Both functions are template parameters, so lambdas are called directly and can be inlined into the pairwise loop.
+     * For distance results (int, or anything with an int distance member) min_func can be left out, the smaller distance wins.
+     * With that default, a result over the bound (DISTANCE_OVER_BOUND) is dropped without comparing, and a distance of 0 ends the search, since nothing can beat it.
+     * With that default and a comparison_func that has a lower_bound() (see Lower_Bounded_Comparison, e.g. Levenshtein_Comparison), pairs are compared in ascending order of their bound, and those that can't beat the best pair aren't compared at all, see block_compare_pronunciations().
+     * Also with that default, and threads from set_combination_threads(), texts with at least COMBINATION_PARALLEL_PAIRS pairs of combinations have their pairs shared out across the threads, see block_compare_pronunciations(). comparison_func must then be safe to call from several threads at once, and the minimum it is given only carries a distance. The result is the one the calling thread alone would find.
      * 
      * @param text1 (string): first text string to compare
      * @param text2 (string): second text string to compare
-     * @param comparison_func (function): function that takes two vectors of strings (phonemes) and returns a result
-     * @param min_func (function): function that compares two results and returns true if first is less than second
+     * @param comparison_func (callable): function that takes two PhonemeSequences and the minimum result so far (empty for the first pair), and returns a result. The minimum can be used as a bound, any result that isn't less than it is discarded.
+     * @param min_func (callable): function that compares two results and returns true if first is less than second
      * @return std::expected containing either the minimum result from the comparison function, or an error if any words failed to be identified
     */
-    template<typename ResultType>
+    template<typename ResultType, typename ComparisonFunc, typename MinFunc = Smaller_Distance>
+        requires std::is_invocable_r_v<ResultType, ComparisonFunc&, const PhonemeSequence&, const PhonemeSequence&, const std::optional<ResultType>&>
+              && std::is_invocable_r_v<bool, MinFunc&, const ResultType&, const ResultType&>
     std::expected<ResultType, UnidentifiedWords> compare_text_pronunciations(
         const std::string& text1, 
         const std::string& text2,
-        std::function<ResultType(const std::vector<std::string>&, const std::vector<std::string>&)> comparison_func,
-        std::function<bool(const ResultType&, const ResultType&)> min_func
+        ComparisonFunc&& comparison_func,
+        MinFunc&& min_func = {}
     ) {
-        // Get pronunciation combinations for both texts
-        auto combinations1_result = get_text_pronunciation_combinations(text1);
-        auto combinations2_result = get_text_pronunciation_combinations(text2);
-        
-        // Check if either text has unidentified words and collect all of them
-        std::vector<std::string> all_failed_words;
-        if (!combinations1_result.has_value()) {
-            all_failed_words.insert(all_failed_words.end(), 
-                combinations1_result.error().words.begin(), 
-                combinations1_result.error().words.end());
-        }
-        if (!combinations2_result.has_value()) {
-            all_failed_words.insert(all_failed_words.end(), 
-                combinations2_result.error().words.begin(), 
-                combinations2_result.error().words.end());
+        auto combinations = stream_texts_pronunciation_combinations(text1, text2);
+        if (!combinations) {
+            return std::unexpected(combinations.error());
         }
-        
-        // If there are any failed words, return them all together
-        if (!all_failed_words.empty()) {
-            return std::unexpected(UnidentifiedWords{all_failed_words});
-        }
-        
-        const auto& combinations1 = combinations1_result.value();
-        const auto& combinations2 = combinations2_result.value();
+        auto& [combinations1, combinations2] = combinations.value();
         
         // Apply comparison function to all combinations and find minimum
-        ResultType minimum_result{};
-        bool first_flag = true;
-        
-        for (const auto& combination1 : combinations1) {
-            // Convert combination1 to a single pronunciation string
-            std::string combined_pronunciation1;
-            for (size_t i = 0; i < combination1.size(); ++i) {
-                if (i > 0) {
-                    combined_pronunciation1 += " ";
+        std::optional<ResultType> minimum_result{};
+        if (combinations1.empty() || combinations2.empty()) {
+            return ResultType{};
+        }
+
+        const std::vector<PhonemeSequence> pronunciations2{all_pronunciations(combinations2)};
+
+        constexpr bool by_distance{Distance_Result<ResultType> && std::is_same_v<std::remove_cvref_t<MinFunc>, Smaller_Distance>};
+        if constexpr (by_distance) {
+            if (pronunciations2.size() < std::numeric_limits<std::uint32_t>::max()) {
+                const auto at_least = [&](std::size_t pairs) { return combinations1.count() >= (pairs + pronunciations2.size() - 1) / pronunciations2.size(); };
+                if (combination_pool && at_least(COMBINATION_PARALLEL_PAIRS)) {
+                    return block_compare_pronunciations<ResultType>(combinations1, pronunciations2, comparison_func, combination_pool.get()).result;
                 }
-                combined_pronunciation1 += combination1[i];
-            }
-            
-            auto phones_vector1 = phones_string_to_vector(combined_pronunciation1);
-            
-            for (const auto& combination2 : combinations2) {
-                // Convert combination2 to a single pronunciation string
-                std::string combined_pronunciation2;
-                for (size_t i = 0; i < combination2.size(); ++i) {
-                    if (i > 0) {
-                        combined_pronunciation2 += " ";
+                if constexpr (Lower_Bounded_Comparison<std::remove_cvref_t<ComparisonFunc>>) {
+                    if (at_least(LOWER_BOUND_PAIRS)) {
+                        return block_compare_pronunciations<ResultType>(combinations1, pronunciations2, comparison_func, nullptr).result;
                     }
-                    combined_pronunciation2 += combination2[i];
                 }
-                
-                auto phones_vector2 = phones_string_to_vector(combined_pronunciation2);
-                
-                // Apply the comparison function
-                ResultType result = comparison_func(phones_vector1, phones_vector2);
-                
-                if (first_flag) {
-                    minimum_result = result;
-                    first_flag = false;
+            }
+        }
+        do {
+            const PhonemeSequence& pronunciation1{combinations1.current()};
+            for (const auto& pronunciation2 : pronunciations2) {
+                ResultType result = comparison_func(pronunciation1, pronunciation2, minimum_result);
+
+                if constexpr (by_distance) {
+                    const int distance{result_distance(result)};
+                    if (minimum_result && (distance == DISTANCE_OVER_BOUND || distance >= result_distance(*minimum_result))) {
+                        continue;
+                    }
+                    minimum_result = std::move(result);
+                    if (distance == 0) {
+                        return std::move(*minimum_result);
+                    }
                 } else {
-                    if (min_func(result, minimum_result)) {
-                        minimum_result = result;
+                    if (!minimum_result || min_func(result, *minimum_result)) {
+                        minimum_result = std::move(result);
                     }
                 }
             }
-        }
+        } while (combinations1.next());
         
-        return minimum_result;
+        return std::move(*minimum_result);
     }
     
     /**
      * Convenience function to get minimum alignment distance between two texts.
      * 
+     * Texts with more than one pronunciation are compared as lattices (see lattice_distance()), in one DP, rather than pair by pair of combinations. Texts with one each get the row kernels, and the pool for document-length ones.
+     * 
      * @param text1 (string): first text string to compare
      * @param text2 (string): second text string to compare
      * @return std::expected containing either the minimum alignment distance, or an error if any words failed to be identified
@@ -234,12 +565,60 @@ public:
      * @return std::expected containing either the minimum alignment, or an error if any words failed to be identified
     */
     std::expected<Alignment_And_Distance, UnidentifiedWords> minimum_text_alignment(const std::string& text1, const std::string& text2);
+
+    /**
+     * minimum_text_alignment() as an edit script: runs of matches, substitutions, insertions and deletions indexing the two winning pronunciations, rather than padded columns of strings. Much smaller to keep or send, and to_alignment_and_distance() turns it into the columns when they are needed.
+     * 
+     * @param text1 (string): first text string to compare
+     * @param text2 (string): second text string to compare
+     * @return std::expected containing either the edit script of the minimum alignment, or an error if any words failed to be identified
+    */
+    std::expected<Edit_Script_And_Distance, UnidentifiedWords> minimum_text_edit_script(const std::string& text1, const std::string& text2);
+
+    /**
+     * The k closest pronunciation pairs of two texts as edit scripts, closest first, e.g. to show alternative readings next to the best one.
+     * 
+     * Every pair is scored with the distance alone, bounded by the k-th best so far, and only the k survivors are aligned, so asking for a few costs about as much as minimum_text_edit_script(). Pairs at the same distance keep the order of the pronunciations.
+     * 
+     * @param text1 (string): first text string to compare
+     * @param text2 (string): second text string to compare
+     * @param k (size_t): how many pairs to keep, fewer if the texts don't have that many
+     * @return std::expected containing either the edit scripts, sorted by distance, or an error if any words failed to be identified
+    */
+    std::expected<std::vector<Edit_Script_And_Distance>, UnidentifiedWords> minimum_text_edit_scripts(const std::string& text1, const std::string& text2, std::size_t k);
+
+    /**
+     * Lets minimum_text_alignment(), minimum_text_edit_script() and minimum_text_edit_scripts() spread long alignments (stanzas, pages) over several threads, see hirschberg() and HIRSCHBERG_PARALLEL_CELLS, and minimum_text_distance() do the same for document-length texts, see levenshtein_distance(..., pool). Results are the same either way, and short texts stay on the calling thread.
+     * 
+     * Off by default. The threads are started here, and kept until the next call or until this object goes away, so don't call it while an alignment is running.
+     * 
+     * @param threads (size_t): threads to align on, counting the calling thread; 0 or 1 turns it off
+    */
+    void set_alignment_threads(std::size_t threads);
+
+    /**
+     * Lets compare_text_pronunciations() (by distance) and minimum_text_alignment(), minimum_text_edit_script() and minimum_text_edit_scripts(..., 1) share out the pairs of pronunciation combinations of texts with many of them, at least COMBINATION_PARALLEL_PAIRS, over several threads. Results are the same either way.
+     * 
+     * Off by default, and separate from set_alignment_threads(), as a comparison_func given to compare_text_pronunciations() is then called from several threads at once. The threads are started here, and kept until the next call or until this object goes away, so don't call it while a comparison is running.
+     * 
+     * @param threads (size_t): threads to compare on, counting the calling thread; 0 or 1 turns it off
+    */
+    void set_combination_threads(std::size_t threads);
     
     /**
-     *
+     * Possible pronunciations of the end of a line: its last word, and the words before it back to one that is stressed in every pronunciation, so a line ending on e.g. "of the" keeps its rhyme. One interned sequence per combination.
+     * 
+     * @param line (string): string of english words
+     * @return std::expected containing either the pronunciations, or an error with the unidentified words among those needed (the empty string for an empty line)
+    */
+    std::expected<std::vector<PhonemeSequence>, UnidentifiedWords> get_line_end_pronunciations(const std::string& line);
+
+    /**
+     * How well two lines rhyme: the minimum end_rhyme_distance() over every pair of their get_line_end_pronunciations(), one DP per pair over the whole line ends, anchored at the end with the material before the rhymes free.
+     * 
      * @param line1 (string): string of english words
      * @param line2 (string): string of english words
-     * @return std::expected containing either the rhyme distance, or a RhymeError if the operation fails
+     * @return std::expected containing either the rhyme distance, or an error with the unidentified words of both lines
     */
     std::expected<int, UnidentifiedWords> get_end_rhyme_distance(const std::string& line1, const std::string& line2);
 };
@@ -0,0 +1,276 @@
+#pragma once
+
+#include <algorithm>
+#include <compare>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+/**
+ * Contiguous sequence with room for N elements inside the object itself, only going to the heap once it grows past N.
+ *
+ * Rhyming parts and single word pronunciations are nearly always short, and they are created and thrown away by the thousand for every comparison, so keeping them inline saves an allocation each. The interface is the subset of std::vector this repo uses, and it is a contiguous range, so it converts to std::span like a vector does.
+ *
+ * Unlike std::vector, moving an inline SmallVector moves its elements one by one, and iterators are invalidated by moves as well as by growth.
+*/
+template<typename T, std::size_t N>
+class SmallVector {
+public:
+    static_assert(N > 0, "SmallVector needs room for at least one inline element");
+
+    using value_type = T;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = T&;
+    using const_reference = const T&;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    static constexpr size_type inline_capacity{N};
+
+    SmallVector() = default;
+
+    explicit SmallVector(size_type count) {
+        resize(count);
+    }
+
+    SmallVector(size_type count, const T& value) {
+        assign(count, value);
+    }
+
+    SmallVector(std::initializer_list<T> values) {
+        assign(values.begin(), values.end());
+    }
+
+    template<std::forward_iterator Iterator>
+    SmallVector(Iterator first, Iterator last) {
+        assign(first, last);
+    }
+
+    SmallVector(const SmallVector& other) {
+        assign(other.begin(), other.end());
+    }
+
+    SmallVector(SmallVector&& other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+        take(std::move(other));
+    }
+
+    ~SmallVector() {
+        release();
+    }
+
+    SmallVector& operator=(const SmallVector& other) {
+        if (this != &other) {
+            assign(other.begin(), other.end());
+        }
+        return *this;
+    }
+
+    SmallVector& operator=(SmallVector&& other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+        if (this != &other) {
+            release();
+            take(std::move(other));
+        }
+        return *this;
+    }
+
+    SmallVector& operator=(std::initializer_list<T> values) {
+        assign(values.begin(), values.end());
+        return *this;
+    }
+
+    void assign(size_type count, const T& value) {
+        clear();
+        reserve(count);
+        std::uninitialized_fill_n(data_, count, value);
+        size_ = count;
+    }
+
+    template<std::forward_iterator Iterator>
+    void assign(Iterator first, Iterator last) {
+        clear();
+        reserve(static_cast<size_type>(std::distance(first, last)));
+        size_ = std::uninitialized_copy(first, last, data_) - data_;
+    }
+
+    T* data() noexcept { return data_; }
+    const T* data() const noexcept { return data_; }
+    size_type size() const noexcept { return size_; }
+    size_type capacity() const noexcept { return capacity_; }
+    bool empty() const noexcept { return size_ == 0; }
+
+    // Whether the elements are still in the inline buffer, i.e. nothing has been allocated
+    bool is_inline() const noexcept { return data_ == inline_data(); }
+
+    iterator begin() noexcept { return data_; }
+    iterator end() noexcept { return data_ + size_; }
+    const_iterator begin() const noexcept { return data_; }
+    const_iterator end() const noexcept { return data_ + size_; }
+    const_iterator cbegin() const noexcept { return data_; }
+    const_iterator cend() const noexcept { return data_ + size_; }
+
+    T& operator[](size_type index) { return data_[index]; }
+    const T& operator[](size_type index) const { return data_[index]; }
+
+    T& at(size_type index) {
+        if (index >= size_) {
+            throw std::out_of_range("SmallVector index out of range");
+        }
+        return data_[index];
+    }
+    const T& at(size_type index) const {
+        if (index >= size_) {
+            throw std::out_of_range("SmallVector index out of range");
+        }
+        return data_[index];
+    }
+
+    T& front() { return data_[0]; }
+    const T& front() const { return data_[0]; }
+    T& back() { return data_[size_ - 1]; }
+    const T& back() const { return data_[size_ - 1]; }
+
+    void reserve(size_type new_capacity) {
+        if (new_capacity <= capacity_) {
+            return;
+        }
+        T* new_data = std::allocator<T>{}.allocate(new_capacity);
+        std::uninitialized_move(data_, data_ + size_, new_data);
+        std::destroy(data_, data_ + size_);
+        deallocate();
+        data_ = new_data;
+        capacity_ = new_capacity;
+    }
+
+    void resize(size_type count) {
+        if (count < size_) {
+            std::destroy(data_ + count, data_ + size_);
+        }
+        else {
+            reserve(count);
+            std::uninitialized_value_construct(data_ + size_, data_ + count);
+        }
+        size_ = count;
+    }
+
+    void resize(size_type count, const T& value) {
+        if (count < size_) {
+            std::destroy(data_ + count, data_ + size_);
+        }
+        else {
+            reserve(count);
+            std::uninitialized_fill(data_ + size_, data_ + count, value);
+        }
+        size_ = count;
+    }
+
+    void clear() noexcept {
+        std::destroy(data_, data_ + size_);
+        size_ = 0;
+    }
+
+    template<typename... Args>
+    T& emplace_back(Args&&... args) {
+        if (size_ == capacity_) {
+            // args may refer to an element, which growing would move out from under them
+            T value(std::forward<Args>(args)...);
+            grow(size_ + 1);
+            T* element = std::construct_at(data_ + size_, std::move(value));
+            ++size_;
+            return *element;
+        }
+        T* element = std::construct_at(data_ + size_, std::forward<Args>(args)...);
+        ++size_;
+        return *element;
+    }
+
+    void push_back(const T& value) { emplace_back(value); }
+    void push_back(T&& value) { emplace_back(std::move(value)); }
+
+    void pop_back() {
+        --size_;
+        std::destroy_at(data_ + size_);
+    }
+
+    // Inserts value before position, returning an iterator to it
+    iterator insert(const_iterator position, const T& value) {
+        const size_type offset = position - data_;
+        emplace_back(value);
+        std::rotate(data_ + offset, data_ + size_ - 1, data_ + size_);
+        return data_ + offset;
+    }
+
+    // Inserts [first, last) before position, returning an iterator to the first inserted element. [first, last) can't point into *this.
+    template<std::forward_iterator Iterator>
+    iterator insert(const_iterator position, Iterator first, Iterator last) {
+        const size_type offset = position - data_;
+        const size_type old_size = size_;
+        const size_type count = static_cast<size_type>(std::distance(first, last));
+        if (size_ + count > capacity_) {
+            grow(size_ + count);
+        }
+        std::uninitialized_copy(first, last, data_ + size_);
+        size_ += count;
+        std::rotate(data_ + offset, data_ + old_size, data_ + size_);
+        return data_ + offset;
+    }
+
+    friend bool operator==(const SmallVector& one, const SmallVector& two) {
+        return std::equal(one.begin(), one.end(), two.begin(), two.end());
+    }
+
+    friend auto operator<=>(const SmallVector& one, const SmallVector& two) {
+        return std::lexicographical_compare_three_way(one.begin(), one.end(), two.begin(), two.end());
+    }
+
+private:
+    T* inline_data() noexcept { return reinterpret_cast<T*>(inline_buffer_); }
+    const T* inline_data() const noexcept { return reinterpret_cast<const T*>(inline_buffer_); }
+
+    // Doubles, so that repeated emplace_back() stays amortized constant
+    void grow(size_type needed) {
+        reserve(std::max(needed, capacity_ * 2));
+    }
+
+    void deallocate() noexcept {
+        if (!is_inline()) {
+            std::allocator<T>{}.deallocate(data_, capacity_);
+        }
+    }
+
+    void release() noexcept {
+        std::destroy(data_, data_ + size_);
+        deallocate();
+        data_ = inline_data();
+        size_ = 0;
+        capacity_ = N;
+    }
+
+    // Only called with *this empty and inline. Steals other's heap buffer, or moves its inline elements over.
+    void take(SmallVector&& other) {
+        if (other.is_inline()) {
+            std::uninitialized_move(other.begin(), other.end(), data_);
+            size_ = other.size_;
+            other.clear();
+        }
+        else {
+            data_ = other.data_;
+            size_ = other.size_;
+            capacity_ = other.capacity_;
+            other.data_ = other.inline_data();
+            other.size_ = 0;
+            other.capacity_ = N;
+        }
+    }
+
+    T* data_{inline_data()};
+    size_type size_{0};
+    size_type capacity_{N};
+    alignas(T) std::byte inline_buffer_[N * sizeof(T)];
+};
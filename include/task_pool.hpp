@@ -0,0 +1,160 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Fixed set of worker threads for fork-join parallelism, e.g. the two halves of a hirschberg() level.
+ *
+ * fork_join() runs one callable on the calling thread and offers the other to the workers. If no worker has picked it up by the time the first is done, the caller takes it back and runs it too, so a pool with every worker busy degrades to running things serially rather than deadlocking, and a pool of 1 thread never starts one.
+ *
+ * A thread waiting in fork_join() only ever waits for a task another thread is already running. It doesn't run unrelated tasks while it waits, so a task may keep per-thread scratch (see scratch_buffer()) across its fork_join() calls.
+ *
+ * Builds without thread support (e.g. Emscripten without -pthread) can still use a pool of 1 thread.
+*/
+class Task_Pool {
+public:
+    /**
+     * @param threads (size_t): threads to run on, counting the ones that call fork_join(), so threads - 1 workers are started. 0 is taken as 1.
+    */
+    explicit Task_Pool(std::size_t threads) {
+        for (std::size_t k{1}; k < threads; ++k) {
+            workers.emplace_back([this] { work(); });
+        }
+    }
+
+    ~Task_Pool() {
+        {
+            std::lock_guard lock{mutex};
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    Task_Pool(const Task_Pool&) = delete;
+    Task_Pool& operator=(const Task_Pool&) = delete;
+
+    // Threads the pool runs on, counting the caller
+    std::size_t size() const noexcept { return workers.size() + 1; }
+
+    /**
+     * Runs left() on this thread and right() on whichever thread gets to it first, and returns once both are done.
+     *
+     * An exception from either is rethrown here, after both have finished, left's first.
+    */
+    template<typename Left, typename Right>
+    void fork_join(Left&& left, Right&& right) {
+        if (workers.empty()) {
+            left();
+            right();
+            return;
+        }
+
+        Task task{std::ref(right)};
+        {
+            std::lock_guard lock{mutex};
+            queue.push_back(&task);
+        }
+        wake.notify_one();
+
+        std::exception_ptr left_error{};
+        try {
+            left();
+        }
+        catch (...) {
+            left_error = std::current_exception();
+        }
+
+        bool taken_back{};
+        {
+            std::unique_lock lock{mutex};
+            const auto queued = std::find(queue.begin(), queue.end(), &task);
+            if (queued != queue.end()) {
+                queue.erase(queued);
+                taken_back = true;
+            }
+            else {
+                finished.wait(lock, [&task] { return task.done; });
+            }
+        }
+        if (taken_back) {
+            run(task);
+        }
+
+        if (left_error) {
+            std::rethrow_exception(left_error);
+        }
+        if (task.error) {
+            std::rethrow_exception(task.error);
+        }
+    }
+
+    /**
+     * Calls body(k) for every k in [begin, end), splitting the range in halves with fork_join(), and returns once all are done.
+    */
+    template<typename Body>
+    void parallel_for(std::size_t begin, std::size_t end, Body&& body) {
+        if (workers.empty() || end - begin <= 1) {
+            for (std::size_t k{begin}; k < end; ++k) {
+                body(k);
+            }
+            return;
+        }
+        const std::size_t mid = begin + (end - begin) / 2;
+        fork_join([&] { parallel_for(begin, mid, body); },
+                  [&] { parallel_for(mid, end, body); });
+    }
+
+private:
+    struct Task {
+        std::function<void()> body;
+        std::exception_ptr error{};
+        bool done{};
+    };
+
+    static void run(Task& task) {
+        try {
+            task.body();
+        }
+        catch (...) {
+            task.error = std::current_exception();
+        }
+    }
+
+    // Oldest task first: the first forked are the biggest
+    void work() {
+        std::unique_lock lock{mutex};
+        while (true) {
+            wake.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (queue.empty()) {
+                return;
+            }
+            Task* task = queue.front();
+            queue.pop_front();
+
+            lock.unlock();
+            run(*task);
+            lock.lock();
+
+            task->done = true;
+            finished.notify_all();
+        }
+    }
+
+    std::mutex mutex{};
+    std::condition_variable wake{};
+    std::condition_variable finished{};
+    std::deque<Task*> queue{};
+    bool stopping{};
+    std::vector<std::thread> workers{};
+};
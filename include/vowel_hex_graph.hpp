@@ -1,20 +1,27 @@
 #pragma once
 
+#include "phoneme_id.hpp"
+
+#include <array>
+#include <cstddef>
+#include <stdexcept>
 #include <string>
-#include <unordered_map>
+#include <string_view>
 #include <utility>
 #include <vector>
 
 
 /**
- * Uses Static Storage for Distances.
+ * The graph is fixed, so every distance is calculated at compile time.
  * 
  * USAGE:
  * 
- * VowelHexGraph::initialize();
  * VowelHexGraph::get_distance(vowel1, vowel2);
 */
 class VowelHexGraph {
+public:
+    using DistanceTable = std::array<std::array<int, PHONEME::VOWEL_COUNT>, PHONEME::VOWEL_COUNT>;
+
 private:
 
     /**
@@ -40,7 +47,7 @@ private:
              .:: .-.    .=. ::.                                                           
      * 
      * 
-     * Which is modeled here as an adjacency map where each vowel is keyed to a vector of connected vowels.
+     * Which is modeled here as a constexpr edge list between vowel IDs, i.e. indices into PHONEME::VOWEL_SYMBOLS.
      * 
      * DIPTHONGS:
      * 
@@ -61,61 +68,190 @@ private:
      * NOTE: some of the diphthongs start in in-between locations on the hex-graph, but end in either UH or IH.
     
     */
-    static inline bool initialized = false;
-    static inline std::unordered_map<std::string, std::vector<std::string>>  adjacency_map{};
-
-    // custom PairHash Function so that we can use std::unordered_map with a std::pair as a key
-    struct PairHash {
-        template <typename T1, typename T2>
-        std::size_t operator()(const std::pair<T1, T2>& p) const {
-            std::hash<T1> h1;
-            std::hash<T2> h2;
-            return h1(p.first) ^ h2(p.second);
-        }
-    };
-    //  custom equality function for std::pairs where we don't care about order, so that we can use std::pair as a key for std::unordered_map
-    struct PairEqual {
-        template <typename T1, typename T2>
-        bool operator()(const std::pair<T1, T2>& p1, const std::pair<T1, T2>& p2) const {
-            return (p1.first == p2.first && p1.second == p2.second)
-                || (p1.first == p2.second && p1.second == p2.first);
-        }
-    };
+    static constexpr std::array<std::pair<std::string_view, std::string_view>, 31> edges{{
+        {"AE", "AA"},
+        {"AE", "AH"},
+        {"AE", "EH"},
+        {"AA", "AO"},
+        {"AA", "AH"},
+        {"EH", "AH"},
+        {"EH", "IH"},
+        {"EH", "IY"},
+        {"AH", "AO"},
+        {"AH", "UH"},
+        {"AH", "IH"},
+        {"AO", "UW"},
+        {"AO", "UH"},
+        {"IY", "IH"},
+        {"IH", "UH"},
+        {"UH", "UW"},
+
+        /**
+         * OPIONATED /ER/ ADJACENCY:
+         *
+         * 2. ER as in BIRD is adjacent to:
+         *    AH as in BUT
+         */
+        {"ER", "AH"},
+
+        /**
+         *
+         * DIPTHONG ADJACENCIES
+         * "AW", "AY", "EY", "OW", "OY" // 5 dipthongs
+         *  bout, bite, bait, boat, boy
+         *
+         * I am making some extremely opinionated decisions here:
+         *
+         * 1. AW as in BOUT is adjacent to:
+         *    UH as in BUSH
+         *    OW as in BOAT
+         *    AH as in BUT
+         *    AA : 2 (satisfied by AH adjacency) ((if you were to get rid of that you'd need to somehow set a distance, e.g. by introducing a notion of distance into edges))
+         *    AE : 2 (see above)
+         */
+        {"AW", "UH"},
+        {"AW", "OW"},
+        {"AW", "AH"},
+        /**
+         *
+         * 2. AY as in BITE is adjacent to:
+         *    IH as in BIT
+         *    EY as in BAIT
+         *    AH as in BUT
+         *    AA : 2 (satisfied by AH adjacency) ((if you were to get rid of that you'd need to somehow set a distance, e.g. by introducing a notion of distance into edges))
+         *    AE : 2 (see above)
+         */
+        {"AY", "IH"},
+        {"AY", "EY"},
+        {"AY", "AH"},
+        /**
+         * 3. EY as in BAIT is adjacent to:
+         *    AY as in BITE *redundant
+         *    IH as in BIT
+         *    EH as in BET
+         *    IY as in BEAT
+         */
+        {"EY", "IH"},
+        {"EY", "EH"},
+        {"EY", "IY"},
+        /** 4. OW as in BOAT is adjacent to:
+         *    OY as in BOY
+         *    AW as in BOUT *redundant
+         *    UH as in BUSH
+         *    UW as in BOOT
+         *    AO as in BOMB
+         */
+        {"OW", "OY"},
+        {"OW", "UH"},
+        {"OW", "UW"},
+        {"OW", "AO"},
+        /* 5. OY as in BOY is adjacent to:
+        *    IH as in BIT
+        *    OW as in BOAT *redundant
+        */
+        {"OY", "IH"}
+    }};
 
-    static inline std::unordered_map<std::pair<std::string, std::string>, int, PairHash, PairEqual> distance_between_vowels_map{};
+    // Every vowel-to-vowel distance, filled in at compile time by calculate_all_distances().
+    static const DistanceTable distance_table;
 
 public:
-    VowelHexGraph();
 
     /**
-     * Adds edges between vowels to out adjacency_map.
+     * Looks up a vowel's ID, i.e. its index in PHONEME::VOWEL_SYMBOLS.
      * 
-     * @param vowel1 (string): arpabet Vowel
-     * @param vowel2 (string): arpabet Vowel
+     * @param vowel (string_view): arpabet Vowel, without stress
+     * @return (size_t) vowel ID
+     * @throws std::out_of_range if vowel isn't one of the 15 arpabet vowels
     */
-    static void add_edge(const std::string& vowel1, const std::string& vowel2);
+    static constexpr std::size_t get_vowel_id(std::string_view vowel) {
+        for (std::size_t i{}; i < PHONEME::VOWEL_COUNT; ++i) {
+            if (PHONEME::VOWEL_SYMBOLS[i] == vowel) {
+                return i;
+            }
+        }
+        throw std::out_of_range("Vowel not found");
+    }
 
     /**
      * Runs a Breadth-First-Search to find the shortest path between two vowels.
      * 
-     * @param vowel1 (string): arpabet Vowel
-     * @param vowel2 (string): arpabet Vowel
-     * @return (int) hex-distance between vowels;
+     * @param vowel1 (size_t): vowel ID
+     * @param vowel2 (size_t): vowel ID
+     * @return (int) hex-distance between vowels, or -1 if they aren't connected
     */
-    static int calculate_shortest_distance(const std::string& vowel1, const std::string& vowel2);
+    static constexpr int calculate_shortest_distance(std::size_t vowel1, std::size_t vowel2) {
+        // If both vowels are the same, the distance is 0
+        if (vowel1 == vowel2) return 0;
+
+        // Fixed size queue for BFS, each vowel gets queued at most once, and distances double as the visited set
+        std::array<std::size_t, PHONEME::VOWEL_COUNT> to_visit{};
+        std::size_t front{};
+        std::size_t back{};
+        std::array<int, PHONEME::VOWEL_COUNT> distances{};
+        distances.fill(-1);
+
+        // Initialize BFS
+        to_visit[back++] = vowel1;
+        distances[vowel1] = 0;
+
+        // Perform BFS
+        while (front < back) {
+            const std::size_t current_vowel{to_visit[front++]};
+
+            // Check all connected vowels
+            for (const auto& [a, b] : edges) {
+                std::size_t neighbor{};
+                if (get_vowel_id(a) == current_vowel) {
+                    neighbor = get_vowel_id(b);
+                }
+                else if (get_vowel_id(b) == current_vowel) {
+                    neighbor = get_vowel_id(a);
+                }
+                else {
+                    continue;
+                }
+
+                if (neighbor == vowel2) {
+                    return distances[current_vowel] + 1; // Found the target vowel
+                }
+                if (distances[neighbor] == -1) {
+                    distances[neighbor] = distances[current_vowel] + 1;
+                    to_visit[back++] = neighbor;
+                }
+            }
+        }
+
+        // If we complete the BFS without finding vowel2, return -1
+        return -1;
+    }
 
     /**
-     * Calculates all the distances between vowels and adds them to distance_between_vowels_map
+     * String version of calculate_shortest_distance().
      * 
+     * @param vowel1 (string_view): arpabet Vowel
+     * @param vowel2 (string_view): arpabet Vowel
+     * @return (int) hex-distance between vowels;
     */
-    static void calculate_all_distances();
+    static constexpr int calculate_shortest_distance(std::string_view vowel1, std::string_view vowel2) {
+        return calculate_shortest_distance(get_vowel_id(vowel1), get_vowel_id(vowel2));
+    }
 
     /**
-     * Initializes this class with hard-coded vowel connections.
-     * Also pre-calculates all the distances between vowels.
+     * Calculates all the distances between vowels.
      * 
+     * @return 15x15 table of hex-distances, indexed by vowel ID
     */
-    static void initialize();
+    static constexpr DistanceTable calculate_all_distances() {
+        DistanceTable distances{};
+        for (std::size_t i{}; i < PHONEME::VOWEL_COUNT; ++i) {
+            for (std::size_t j{i}; j < PHONEME::VOWEL_COUNT; ++j) {
+                distances[i][j] = calculate_shortest_distance(i, j);
+                distances[j][i] = distances[i][j];
+            }
+        }
+        return distances;
+    }
 
     /**
      * Returns a vector of vowels connected to a particular vowel node.
@@ -127,7 +263,7 @@ public:
     static std::vector<std::string> get_connected_vowels(const std::string& vowel);
 
     /**
-     * This checks the pre-calculated distances using distance_between_vowels_map;
+     * This checks the pre-calculated distances in distance_table.
      * 
      * Speed test:
      * for 10,000 searches:
@@ -137,12 +273,20 @@ public:
      * Note: same answers for running this in either direction.
      * 
      * 
-     * @param vowel1 (string): arpabet vowel
-     * @param vowel2 (string): arpabet vowel
+     * @param vowel1 (size_t): vowel ID
+     * @param vowel2 (size_t): vowel ID
      * @return (int) hex-distance from vowel1 to vowel2
     */
-   
-    static int get_distance(const std::string& vowel1, const std::string& vowel2);
+    static constexpr int get_distance(std::size_t vowel1, std::size_t vowel2);
+
+    /**
+     * String version of get_distance().
+     * 
+     * @param vowel1 (string_view): arpabet vowel
+     * @param vowel2 (string_view): arpabet vowel
+     * @return (int) hex-distance from vowel1 to vowel2
+    */
+    static constexpr int get_distance(std::string_view vowel1, std::string_view vowel2);
 
     /**
      * TODO: How to define vowel distance between diphthongs?
@@ -152,3 +296,13 @@ public:
      */
       
 };
+
+inline constexpr VowelHexGraph::DistanceTable VowelHexGraph::distance_table{VowelHexGraph::calculate_all_distances()};
+
+constexpr int VowelHexGraph::get_distance(std::size_t vowel1, std::size_t vowel2) {
+    return distance_table[vowel1][vowel2];
+}
+
+constexpr int VowelHexGraph::get_distance(std::string_view vowel1, std::string_view vowel2) {
+    return distance_table[get_vowel_id(vowel1)][get_vowel_id(vowel2)];
+}
@@ -11,6 +11,10 @@ ConsonantDistance::ConsonantDistance(){
 }
 
 void ConsonantDistance::initialize(){
+   if (!consonants.empty()) {
+      return;
+   }
+
    consonants = {
       {"CH", Manner::affricate, true, false, 5},
       {"JH", Manner::affricate, true, true, 5},
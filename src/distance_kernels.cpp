@@ -0,0 +1,149 @@
+#include "distance_kernels.hpp"
+
+#include <cstdlib>
+
+// Defined in distance_kernels_<isa>.cpp, only when that file is built (see CMakeLists.txt)
+#if defined(RHYME_AND_METER_AVX2)
+void levenshtein_last_row_avx2(std::span<const PhonemeId> X, std::span<const PhonemeId> Y,
+                               std::span<const int> gaps_x, std::span<const int> gaps_y,
+                               const PhonemeCostTable& costs, std::span<int> last_row);
+void levenshtein_block_avx2(std::span<const PhonemeId> X, std::span<const PhonemeId> Y,
+                            std::span<const int> gaps_x, std::span<const int> gaps_y,
+                            const PhonemeCostTable& costs, std::span<int> top, std::span<int> left);
+void levenshtein_distance_batch_avx2(std::span<const PhonemeId> query, std::span<const int> query_gaps,
+                                     std::span<const std::span<const PhonemeId>> candidates,
+                                     std::span<int> distances,
+                                     const PhonemeCostTable& costs);
+#endif
+
+#if defined(RHYME_AND_METER_AVX512)
+void levenshtein_last_row_avx512(std::span<const PhonemeId> X, std::span<const PhonemeId> Y,
+                                 std::span<const int> gaps_x, std::span<const int> gaps_y,
+                                 const PhonemeCostTable& costs, std::span<int> last_row);
+void levenshtein_block_avx512(std::span<const PhonemeId> X, std::span<const PhonemeId> Y,
+                              std::span<const int> gaps_x, std::span<const int> gaps_y,
+                              const PhonemeCostTable& costs, std::span<int> top, std::span<int> left);
+#endif
+
+std::optional<KernelIsa> parse_kernel_isa(std::string_view name) {
+    if (name == "scalar") return KernelIsa::Scalar;
+    if (name == "avx2") return KernelIsa::AVX2;
+    if (name == "avx512") return KernelIsa::AVX512;
+    return std::nullopt;
+}
+
+bool kernel_isa_available(KernelIsa isa) {
+    switch (isa) {
+        case KernelIsa::Scalar:
+            return true;
+        case KernelIsa::AVX2:
+#if defined(RHYME_AND_METER_AVX2)
+            return __builtin_cpu_supports("avx2");
+#else
+            return false;
+#endif
+        case KernelIsa::AVX512:
+#if defined(RHYME_AND_METER_AVX512)
+            return __builtin_cpu_supports("avx512f");
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+namespace {
+    KernelIsa select_kernel_isa(std::size_t length) {
+        KernelIsa isa{KernelIsa::Scalar};
+        for (const KernelIsa candidate : {KernelIsa::AVX2, KernelIsa::AVX512}) {
+            // Short sequences stay on AVX2 if there is one, see AVX512_MIN_LENGTH
+            if (candidate == KernelIsa::AVX512 && length < AVX512_MIN_LENGTH && isa == KernelIsa::AVX2) {
+                continue;
+            }
+            if (kernel_isa_available(candidate)) {
+                isa = candidate;
+            }
+        }
+
+        // Override for testing, ignored if the CPU can't run it
+        if (const char* requested{std::getenv("RHYME_AND_METER_ISA")}) {
+            const auto requested_isa{parse_kernel_isa(requested)};
+            if (requested_isa && kernel_isa_available(*requested_isa)) {
+                isa = *requested_isa;
+            }
+        }
+        return isa;
+    }
+}
+
+KernelIsa kernel_isa() {
+    // CPUID doesn't change while we're running
+    static const KernelIsa isa{select_kernel_isa(AVX512_MIN_LENGTH)};
+    return isa;
+}
+
+KernelIsa kernel_isa(std::size_t length) {
+    if (length >= AVX512_MIN_LENGTH) {
+        return kernel_isa();
+    }
+    static const KernelIsa isa{select_kernel_isa(0)};
+    return isa;
+}
+
+LastRowKernel last_row_kernel(KernelIsa isa) {
+    if (!kernel_isa_available(isa)) {
+        return nullptr;
+    }
+    switch (isa) {
+        case KernelIsa::Scalar:
+            return nullptr;
+        case KernelIsa::AVX2:
+#if defined(RHYME_AND_METER_AVX2)
+            return levenshtein_last_row_avx2;
+#else
+            return nullptr;
+#endif
+        case KernelIsa::AVX512:
+#if defined(RHYME_AND_METER_AVX512)
+            return levenshtein_last_row_avx512;
+#else
+            return nullptr;
+#endif
+    }
+    return nullptr;
+}
+
+BlockKernel block_kernel(KernelIsa isa) {
+    if (!kernel_isa_available(isa)) {
+        return nullptr;
+    }
+    switch (isa) {
+        case KernelIsa::Scalar:
+            return nullptr;
+        case KernelIsa::AVX2:
+#if defined(RHYME_AND_METER_AVX2)
+            return levenshtein_block_avx2;
+#else
+            return nullptr;
+#endif
+        case KernelIsa::AVX512:
+#if defined(RHYME_AND_METER_AVX512)
+            return levenshtein_block_avx512;
+#else
+            return nullptr;
+#endif
+    }
+    return nullptr;
+}
+
+BatchKernel batch_kernel(KernelIsa isa) {
+    // Rhyming parts are short enough that AVX-512 machines use the AVX2 batch kernel too
+    if (isa == KernelIsa::Scalar || !kernel_isa_available(isa) || !kernel_isa_available(KernelIsa::AVX2)) {
+        return nullptr;
+    }
+#if defined(RHYME_AND_METER_AVX2)
+    return levenshtein_distance_batch_avx2;
+#else
+    return nullptr;
+#endif
+}
@@ -0,0 +1,287 @@
+#include "distance_kernels.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <immintrin.h>
+
+// Only the kernels below get AVX2, everything included above (std::vector and friends) is compiled for the baseline, so the linker can't pick an AVX2 copy of them for the rest of the program.
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+namespace {
+    // 8 lanes of 32 bit scores
+    struct Lanes32 {
+        using Score = std::int32_t;
+        static constexpr std::size_t width{8};
+
+        static __m256i load(const Score* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+        static void store(Score* p, __m256i v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+        static __m256i add(__m256i a, __m256i b) { return _mm256_add_epi32(a, b); }
+        static __m256i min(__m256i a, __m256i b) { return _mm256_min_epi32(a, b); }
+        static __m256i set1(int v) { return _mm256_set1_epi32(v); }
+
+        // table[index[k]] for each lane
+        static __m256i gather(const int* table, const int* index) {
+            return _mm256_i32gather_epi32(table, load(index), 4);
+        }
+
+        // table[a[k] + b[k]] for each lane
+        static __m256i gather(const int* table, const int* a, const int* b) {
+            return _mm256_i32gather_epi32(table, add(load(a), load(b)), 4);
+        }
+    };
+
+    // 16 lanes of 16 bit scores. There is no 16 bit gather, so substitution scores are gathered as two halves of 32 bit scores and packed.
+    struct Lanes16 {
+        using Score = std::int16_t;
+        static constexpr std::size_t width{16};
+
+        static __m256i load(const Score* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+        static void store(Score* p, __m256i v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+        static __m256i add(__m256i a, __m256i b) { return _mm256_add_epi16(a, b); }
+        static __m256i min(__m256i a, __m256i b) { return _mm256_min_epi16(a, b); }
+        static __m256i set1(int v) { return _mm256_set1_epi16(static_cast<Score>(v)); }
+
+        // packs works within each 128 bit half, giving [low 0-3, high 0-3 | low 4-7, high 4-7], so put the quadwords back in order
+        static __m256i pack(__m256i low, __m256i high) {
+            return _mm256_permute4x64_epi64(_mm256_packs_epi32(low, high), 0xD8);
+        }
+
+        static __m256i gather(const int* table, const int* index) {
+            return pack(Lanes32::gather(table, index), Lanes32::gather(table, index + 8));
+        }
+    };
+
+    /**
+     * Anti-diagonal fill.
+     *
+     * Every cell (i, j) on anti-diagonal d = i + j depends only on diagonals d-1 and d-2, so a whole diagonal can be computed at once. Diagonals are stored indexed by row i:
+     *
+     *  diag0[i] = D(i, d-i)
+     *  diag1[i] = D(i, d-1-i)    (deletion from diag1[i-1], insertion from diag1[i])
+     *  diag2[i] = D(i, d-2-i)    (substitution from diag2[i-1])
+     *
+     * Walking down a diagonal, i increases while j decreases, so Y and its gap penalties are stored reversed to make every load contiguous in i.
+     *
+     * The last row, D(n, j), is picked up one cell per diagonal, from diag0[n], and so is the last column, D(i, m), when it is wanted.
+     *
+     * The first row and column, D(0, j) and D(i, 0), are running sums of the gap penalties, unless top_edge and left_edge give them (for a block of a larger DP). They are copied before anything is written, so the outputs may be the edges.
+     *
+     * Scores are 32 bit: Lanes16 is no faster here, the diagonal is bound by its gathers and 16 lanes take two of them.
+    */
+    void last_row_diagonal(std::span<const PhonemeId> X, std::span<const PhonemeId> Y,
+                           std::span<const int> gaps_x, std::span<const int> gaps_y,
+                           const PhonemeCostTable& costs, std::span<const int> top_edge, std::span<const int> left_edge,
+                           std::span<int> last_row, std::span<int> last_column) {
+        using Score = Lanes32::Score;
+        constexpr int width{static_cast<int>(Lanes32::width)};
+
+        const int n = X.size();
+        const int m = Y.size();
+
+        // Everything lives in two per-thread scratch buffers, see scratch_buffer()
+        struct IndexScratch;
+        struct ScoreScratch;
+        const std::span<int> indices{scratch_buffer<int, IndexScratch>((n + 1) + m)};
+        const std::span<Score> scores{scratch_buffer<Score, ScoreScratch>(5 * (n + 1) + 2 * m + 1)};
+        std::fill(scores.begin(), scores.end(), Score{0});
+
+        // Row-indexed inputs, shifted so that index i belongs to row i
+        int* x_offsets = indices.data();                 // X[i-1] * PHONEME::COUNT, the start of its substitution row
+        Score* x_gaps = scores.data();                   // gaps_x[i-1]
+        Score* left = x_gaps + (n + 1);                  // D(i, 0)
+        x_offsets[0] = 0;
+        left[0] = static_cast<Score>(left_edge.empty() ? 0 : left_edge[0]);
+        for (int i = 1; i <= n; ++i) {
+            x_offsets[i] = X[i - 1] * static_cast<int>(PHONEME::COUNT);
+            x_gaps[i] = static_cast<Score>(gaps_x[i - 1]);
+            left[i] = static_cast<Score>(left_edge.empty() ? left[i - 1] + gaps_x[i - 1] : left_edge[i]);
+        }
+
+        // Column inputs reversed, Y[d-i-1] == y_reversed[m-d+i]
+        int* y_reversed = x_offsets + (n + 1);
+        Score* y_gaps_reversed = left + (n + 1);
+        Score* top = y_gaps_reversed + m;                // D(0, j)
+        top[0] = left[0];
+        for (int k = 0; k < m; ++k) {
+            y_reversed[k] = Y[m - 1 - k];
+            y_gaps_reversed[k] = static_cast<Score>(gaps_y[m - 1 - k]);
+            top[k + 1] = static_cast<Score>(top_edge.empty() ? top[k] + gaps_y[k] : top_edge[k + 1]);
+        }
+
+        Score* diag0 = top + (m + 1);
+        Score* diag1 = diag0 + (n + 1);
+        Score* diag2 = diag1 + (n + 1);
+
+        // d = 0 and d = 1 are all boundary
+        diag2[0] = top[0];
+        diag1[0] = top[1];
+        diag1[1] = left[1];
+        last_row[0] = left[n];
+        if (!last_column.empty()) {
+            last_column[0] = top[m];
+        }
+
+        const int* substitution = costs.substitution.data();
+
+        for (int d = 2; d <= n + m; ++d) {
+            const int i_lo = std::max(1, d - m);
+            const int i_hi = std::min(n, d - 1);
+            const int y_base = m - d;
+
+            if (d <= m) diag0[0] = top[d];
+            if (d <= n) diag0[d] = left[d];
+
+            int i = i_lo;
+            for (; i + width <= i_hi + 1; i += width) {
+                const __m256i deletion = Lanes32::add(Lanes32::load(diag1 + i - 1), Lanes32::load(x_gaps + i));
+                const __m256i insertion = Lanes32::add(Lanes32::load(diag1 + i), Lanes32::load(y_gaps_reversed + y_base + i));
+                const __m256i match = Lanes32::add(Lanes32::load(diag2 + i - 1),
+                                                 Lanes32::gather(substitution, x_offsets + i, y_reversed + y_base + i));
+
+                Lanes32::store(diag0 + i, Lanes32::min(match, Lanes32::min(deletion, insertion)));
+            }
+            // Scalar tail
+            for (; i <= i_hi; ++i) {
+                diag0[i] = static_cast<Score>(std::min({
+                    diag1[i - 1] + x_gaps[i],
+                    diag1[i] + y_gaps_reversed[y_base + i],
+                    diag2[i - 1] + substitution[x_offsets[i] + y_reversed[y_base + i]]
+                }));
+            }
+
+            if (d > n) {
+                last_row[d - n] = diag0[n];
+            }
+            if (d > m && !last_column.empty()) {
+                last_column[d - m] = diag0[d - m];
+            }
+
+            // rotate diagonals
+            std::swap(diag2, diag1);
+            std::swap(diag1, diag0);
+        }
+    }
+
+    /**
+     * Inter-sequence fill, one candidate per lane, for up to Lanes::width candidates.
+     *
+     * Every lane walks the same query row by row, so the query's substitution row and gap penalty are shared, and only the candidate phonemes differ between lanes. Candidates are stored interleaved by column, so that column j of every lane is one contiguous vector:
+     *
+     *  ids[j * width + lane]  = candidates[lane][j]
+     *  gaps[j * width + lane] = gap_penalties(candidates[lane])[j]
+     *
+     * Padding past a candidate's length only feeds cells to the right of it, which are never read for that lane.
+    */
+    template<typename Lanes>
+    void batch_group(std::span<const PhonemeId> query, std::span<const int> query_gaps,
+                     std::span<const std::span<const PhonemeId>> candidates,
+                     std::span<int> distances,
+                     const PhonemeCostTable& costs) {
+        using Score = typename Lanes::Score;
+        constexpr std::size_t lanes{Lanes::width};
+
+        std::size_t width{0};
+        for (const auto& candidate : candidates) {
+            width = std::max(width, candidate.size());
+        }
+
+        // ids and each candidate's gap penalties, then gaps and two rows of (width + 1) columns, one vector of lanes per column
+        struct IndexScratch;
+        struct ScoreScratch;
+        const std::span<int> indices{scratch_buffer<int, IndexScratch>(width * lanes + width)};
+        const std::span<Score> scores{scratch_buffer<Score, ScoreScratch>(width * lanes + 2 * (width + 1) * lanes)};
+        std::fill(indices.begin(), indices.end(), 0);
+        std::fill(scores.begin(), scores.end(), Score{0});
+        int* ids = indices.data();
+        Score* gaps = scores.data();
+        Score* prev = gaps + width * lanes;
+        Score* curr = prev + (width + 1) * lanes;
+
+        const std::span<int> candidate_gaps{indices.subspan(width * lanes)};
+        for (std::size_t lane = 0; lane < candidates.size(); ++lane) {
+            gap_penalties(candidates[lane], candidate_gaps);
+            for (std::size_t j = 0; j < candidates[lane].size(); ++j) {
+                ids[j * lanes + lane] = candidates[lane][j];
+                gaps[j * lanes + lane] = static_cast<Score>(candidate_gaps[j]);
+            }
+        }
+
+        // Base row, running sums of each candidate's gap penalties
+        for (std::size_t j = 1; j <= width; ++j) {
+            Lanes::store(prev + j * lanes, Lanes::add(Lanes::load(prev + (j - 1) * lanes), Lanes::load(gaps + (j - 1) * lanes)));
+        }
+
+        for (std::size_t i = 1; i <= query.size(); ++i) {
+            const int* substitution_row{costs.substitution_row(query[i - 1])};
+            const __m256i deletion_cost = Lanes::set1(query_gaps[i - 1]);
+
+            __m256i left_cell = Lanes::add(Lanes::load(prev), deletion_cost);
+            Lanes::store(curr, left_cell);
+            for (std::size_t j = 1; j <= width; ++j) {
+                const __m256i deletion = Lanes::add(Lanes::load(prev + j * lanes), deletion_cost);
+                const __m256i insertion = Lanes::add(left_cell, Lanes::load(gaps + (j - 1) * lanes));
+                const __m256i match = Lanes::add(Lanes::load(prev + (j - 1) * lanes),
+                                                 Lanes::gather(substitution_row, ids + (j - 1) * lanes));
+
+                left_cell = Lanes::min(match, Lanes::min(deletion, insertion));
+                Lanes::store(curr + j * lanes, left_cell);
+            }
+            std::swap(prev, curr);
+        }
+
+        for (std::size_t lane = 0; lane < candidates.size(); ++lane) {
+            distances[lane] = prev[candidates[lane].size() * lanes + lane];
+        }
+    }
+}
+
+void levenshtein_last_row_avx2(std::span<const PhonemeId> X, std::span<const PhonemeId> Y,
+                               std::span<const int> gaps_x, std::span<const int> gaps_y,
+                               const PhonemeCostTable& costs, std::span<int> last_row) {
+    last_row_diagonal(X, Y, gaps_x, gaps_y, costs, {}, {}, last_row, {});
+}
+
+void levenshtein_block_avx2(std::span<const PhonemeId> X, std::span<const PhonemeId> Y,
+                            std::span<const int> gaps_x, std::span<const int> gaps_y,
+                            const PhonemeCostTable& costs, std::span<int> top, std::span<int> left) {
+    last_row_diagonal(X, Y, gaps_x, gaps_y, costs, top, left, top, left);
+}
+
+void levenshtein_distance_batch_avx2(std::span<const PhonemeId> query, std::span<const int> query_gaps,
+                                     std::span<const std::span<const PhonemeId>> candidates,
+                                     std::span<int> distances,
+                                     const PhonemeCostTable& costs) {
+    std::size_t start = 0;
+    while (start < candidates.size()) {
+        // 16 lanes if the group's longest candidate keeps the scores in 16 bits, 8 otherwise
+        const std::size_t count16{std::min(Lanes16::width, candidates.size() - start)};
+        std::size_t longest{0};
+        for (std::size_t k = start; k < start + count16; ++k) {
+            longest = std::max(longest, candidates[k].size());
+        }
+
+        if (scores_fit<std::int16_t>(query.size(), longest, costs.max_cost)) {
+            batch_group<Lanes16>(query, query_gaps, candidates.subspan(start, count16), distances.subspan(start, count16), costs);
+            start += count16;
+        }
+        else {
+            const std::size_t count32{std::min(Lanes32::width, candidates.size() - start)};
+            batch_group<Lanes32>(query, query_gaps, candidates.subspan(start, count32), distances.subspan(start, count32), costs);
+            start += count32;
+        }
+    }
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
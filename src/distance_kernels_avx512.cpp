@@ -0,0 +1,141 @@
+#include "distance_kernels.hpp"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include <immintrin.h>
+
+// As in distance_kernels_avx2.cpp, only the kernel below is compiled for AVX-512.
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx512f"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+// GCC 12's avx512fintrin.h fills the unused half of some intrinsics with _mm512_undefined_epi32(), which -Wmaybe-uninitialized flags
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+namespace {
+/**
+ * Anti-diagonal fill, the same as last_row_diagonal() in distance_kernels_avx2.cpp with 16 cells per vector.
+ *
+ * See there for how the diagonals are laid out, and for the edges.
+*/
+void last_row_diagonal(std::span<const PhonemeId> X, std::span<const PhonemeId> Y,
+                       std::span<const int> gaps_x, std::span<const int> gaps_y,
+                       const PhonemeCostTable& costs, std::span<const int> top_edge, std::span<const int> left_edge,
+                       std::span<int> last_row, std::span<int> last_column) {
+    const int n = X.size();
+    const int m = Y.size();
+
+    // Everything lives in one per-thread scratch buffer, see scratch_buffer()
+    struct Scratch;
+    const std::span<int> scratch{scratch_buffer<int, Scratch>(6 * (n + 1) + 3 * m + 1)};
+    std::fill(scratch.begin(), scratch.end(), 0);
+
+    // Row-indexed inputs, shifted so that index i belongs to row i
+    int* x_offsets = scratch.data();        // X[i-1] * PHONEME::COUNT, the start of its substitution row
+    int* x_gaps = x_offsets + (n + 1);      // gaps_x[i-1]
+    int* left = x_gaps + (n + 1);           // D(i, 0)
+    left[0] = left_edge.empty() ? 0 : left_edge[0];
+    for (int i = 1; i <= n; ++i) {
+        x_offsets[i] = X[i - 1] * static_cast<int>(PHONEME::COUNT);
+        x_gaps[i] = gaps_x[i - 1];
+        left[i] = left_edge.empty() ? left[i - 1] + gaps_x[i - 1] : left_edge[i];
+    }
+
+    // Column inputs reversed, Y[d-i-1] == y_reversed[m-d+i]
+    int* y_reversed = left + (n + 1);
+    int* y_gaps_reversed = y_reversed + m;
+    int* top = y_gaps_reversed + m;         // D(0, j)
+    top[0] = left[0];
+    for (int k = 0; k < m; ++k) {
+        y_reversed[k] = Y[m - 1 - k];
+        y_gaps_reversed[k] = gaps_y[m - 1 - k];
+        top[k + 1] = top_edge.empty() ? top[k] + gaps_y[k] : top_edge[k + 1];
+    }
+
+    int* diag0 = top + (m + 1);
+    int* diag1 = diag0 + (n + 1);
+    int* diag2 = diag1 + (n + 1);
+
+    // d = 0 and d = 1 are all boundary
+    diag2[0] = top[0];
+    diag1[0] = top[1];
+    diag1[1] = left[1];
+    last_row[0] = left[n];
+    if (!last_column.empty()) {
+        last_column[0] = top[m];
+    }
+
+    const int* substitution = costs.substitution.data();
+
+    for (int d = 2; d <= n + m; ++d) {
+        const int i_lo = std::max(1, d - m);
+        const int i_hi = std::min(n, d - 1);
+        const int y_base = m - d;
+
+        if (d <= m) diag0[0] = top[d];
+        if (d <= n) diag0[d] = left[d];
+
+        int i = i_lo;
+        for (; i + 16 <= i_hi + 1; i += 16) {
+            const __m512i up_left = _mm512_loadu_si512(reinterpret_cast<const void*>(diag2 + i - 1));
+            const __m512i up = _mm512_loadu_si512(reinterpret_cast<const void*>(diag1 + i - 1));
+            const __m512i left_cell = _mm512_loadu_si512(reinterpret_cast<const void*>(diag1 + i));
+
+            const __m512i deletion = _mm512_add_epi32(up, _mm512_loadu_si512(reinterpret_cast<const void*>(x_gaps + i)));
+            const __m512i insertion = _mm512_add_epi32(left_cell, _mm512_loadu_si512(reinterpret_cast<const void*>(y_gaps_reversed + y_base + i)));
+
+            const __m512i index = _mm512_add_epi32(
+                _mm512_loadu_si512(reinterpret_cast<const void*>(x_offsets + i)),
+                _mm512_loadu_si512(reinterpret_cast<const void*>(y_reversed + y_base + i)));
+            const __m512i substitution_score = _mm512_i32gather_epi32(index, substitution, 4);
+            const __m512i match = _mm512_add_epi32(up_left, substitution_score);
+
+            _mm512_storeu_si512(reinterpret_cast<void*>(diag0 + i),
+                                _mm512_min_epi32(match, _mm512_min_epi32(deletion, insertion)));
+        }
+        // Scalar tail
+        for (; i <= i_hi; ++i) {
+            diag0[i] = std::min({
+                diag1[i - 1] + x_gaps[i],
+                diag1[i] + y_gaps_reversed[y_base + i],
+                diag2[i - 1] + substitution[x_offsets[i] + y_reversed[y_base + i]]
+            });
+        }
+
+        if (d > n) {
+            last_row[d - n] = diag0[n];
+        }
+        if (d > m && !last_column.empty()) {
+            last_column[d - m] = diag0[d - m];
+        }
+
+        // rotate diagonals
+        std::swap(diag2, diag1);
+        std::swap(diag1, diag0);
+    }
+}
+}
+
+void levenshtein_last_row_avx512(std::span<const PhonemeId> X, std::span<const PhonemeId> Y,
+                                 std::span<const int> gaps_x, std::span<const int> gaps_y,
+                                 const PhonemeCostTable& costs, std::span<int> last_row) {
+    last_row_diagonal(X, Y, gaps_x, gaps_y, costs, {}, {}, last_row, {});
+}
+
+void levenshtein_block_avx512(std::span<const PhonemeId> X, std::span<const PhonemeId> Y,
+                              std::span<const int> gaps_x, std::span<const int> gaps_y,
+                              const PhonemeCostTable& costs, std::span<int> top, std::span<int> left) {
+    last_row_diagonal(X, Y, gaps_x, gaps_y, costs, top, left, top, left);
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC diagnostic pop
+#pragma GCC pop_options
+#endif
@@ -6,9 +6,14 @@
 #include "hirschberg.hpp"
 #include "levenshtein_distance.hpp"
 
+#include <algorithm>
+#include <cstdint>
 #include <fstream>
 #include <functional>
 #include <iostream>
+#include <iterator>
+#include <limits>
+#include <optional>
 #include <set>
 #include <sstream>
 #include <string>
@@ -374,12 +379,16 @@ Rhyme_and_Meter::compare_end_line_rhyming_parts(const std::string& line1, const
         continue;
     }
 
-    // get pronunciations of each word
+    // get pronunciations of each word, an empty line has no word to pronounce
     auto phones1 = dict.word_to_phones(last_word1);
     auto phones2 = dict.word_to_phones(last_word2);
-    if (!phones1 || !phones2) {
-        unindentified_words.emplace_back(phones1.error().unidentified_word);
-        unindentified_words.emplace_back(phones2.error().unidentified_word);
+    if (!phones1 || phones1->empty()) {
+        unindentified_words.emplace_back(phones1 ? last_word1 : phones1.error().unidentified_word);
+    }
+    if (!phones2 || phones2->empty()) {
+        unindentified_words.emplace_back(phones2 ? last_word2 : phones2.error().unidentified_word);
+    }
+    if (!unindentified_words.empty()) {
         return std::unexpected(UnidentifiedWords{unindentified_words});
     }
 
@@ -410,81 +419,117 @@ Rhyme_and_Meter::compare_end_line_rhyming_parts(const std::string& line1, const
         }
     }
 
+    // every vowel is a syllable, whatever its stress, the same as phone_to_syllable_count()
+    const auto is_stress_digit = [](char c) {
+        return std::isdigit(static_cast<unsigned char>(c)) != 0;
+    };
+
     // cut off front of each rhyming part until they are the length of shortest rhyming part
-    for(auto& r : rhyming_parts1) {
-        if (dict.phone_to_syllable_count(r) > shortest_length) {
-            // get a reverse iterator pointing at the number in the last stressed vowel
-            auto r_it {std::find_if(r.rbegin(), r.rend(), [](char c) {
-                return std::isdigit(c) && c != '0';
-            })};
-            // progress to correct vowel
-            for(int i{}; i < shortest_length - 1; ++i) {
-                ++r_it;
-                auto r_it_more{std::find_if(r_it, r.rend(), [](char c) {
-                    return std::isdigit(c) && c != '0';
-                })};
-                std::swap(r_it, r_it_more);
-            }
-            // move it up to the first char of our vowel
-            r_it += 2;
-            // turn it around
-            // base moves us one to the right, so we got to step it back
-            auto f_it = r_it.base() - 1;
-            std::string clipped_string(f_it, r.end());
-            r = clipped_string;
+    const auto clip_to_shortest = [&](std::string& r) {
+        if (dict.phone_to_syllable_count(r) <= shortest_length) {
+            return;
         }
-    }
-    // TODO: DRY
-    for(auto& r : rhyming_parts2) {
-        if (dict.phone_to_syllable_count(r) > shortest_length) {
-            // get a reverse iterator pointing at the number in the last stressed vowel
-            auto r_it {std::find_if(r.rbegin(), r.rend(), [](char c) {
-                return std::isdigit(c);
-            })};
-            // progress to correct vowel
-            for(int i{}; i < shortest_length - 1; ++i) {
-                ++r_it;
-                auto r_it_more{std::find_if(r_it, r.rend(), [](char c) {
-                    return std::isdigit(c);
-                })};
-                std::swap(r_it, r_it_more);
-            }
-            // move it up to the first char of our vowel
-            r_it += 2;
-            // turn it around
-            // base moves us one to the right, so we got to step it back
-            auto f_it = r_it.base() - 1;
-            std::string clipped_string(f_it, r.end());
-            r = clipped_string;
+        // get a reverse iterator pointing at the number in the last vowel
+        auto r_it {std::find_if(r.rbegin(), r.rend(), is_stress_digit)};
+        // progress to correct vowel
+        for(int i{}; i < shortest_length - 1; ++i) {
+            ++r_it;
+            r_it = std::find_if(r_it, r.rend(), is_stress_digit);
         }
-    }
+        // move it up to the first char of our vowel
+        r_it += 2;
+        // turn it around
+        // base moves us one to the right, so we got to step it back
+        auto f_it = r_it.base() - 1;
+        r = std::string(f_it, r.end());
+    };
+    std::for_each(rhyming_parts1.begin(), rhyming_parts1.end(), clip_to_shortest);
+    std::for_each(rhyming_parts2.begin(), rhyming_parts2.end(), clip_to_shortest);
 
     result = std::make_pair(rhyming_parts1, rhyming_parts2);
     return result;
 }
 
 int Rhyme_and_Meter::minimum_rhyme_distance(const std::pair<std::vector<std::string>, std::vector<std::string>>& pair_of_possible_pronunciations) {
-    int minimum_distance{};
-    bool first_flag{true};
-
+    // convert each rhyming part once, rather than once per pair
+    std::vector<PhonemeSequence> pronunciations1{};
+    std::vector<PhonemeSequence> pronunciations2{};
     for(const auto& p1 : pair_of_possible_pronunciations.first) {
-        for(const auto & p2 : pair_of_possible_pronunciations.second) {
-            int distance = levenshtein_distance(p1, p2);
-            if(first_flag) {
-                minimum_distance = distance;
-                first_flag = false;
-            }
-            else {
-                if(distance < minimum_distance){
-                    minimum_distance = distance;
-                }
+        pronunciations1.emplace_back(phones_string_to_ids(p1));
+    }
+    for(const auto& p2 : pair_of_possible_pronunciations.second) {
+        pronunciations2.emplace_back(phones_string_to_ids(p2));
+    }
+
+    return minimum_rhyme_distance(pronunciations1, pronunciations2);
+}
+
+int Rhyme_and_Meter::minimum_rhyme_distance(std::span<const PhonemeSequence> pronunciations1, std::span<const PhonemeSequence> pronunciations2) {
+    if (pronunciations1.empty() || pronunciations2.empty()) {
+        return 0;
+    }
+    if (pronunciations1.size() * pronunciations2.size() < LOWER_BOUND_PAIRS) {
+        int minimum_distance{DISTANCE_OVER_BOUND};
+        for (const auto& p1 : pronunciations1) {
+            for (const auto& p2 : pronunciations2) {
+                // only pairs closer than the best so far matter, the rest can give up early
+                const int distance = minimum_distance == DISTANCE_OVER_BOUND ? levenshtein_distance(p1, p2) : levenshtein_distance(p1, p2, minimum_distance - 1);
+                minimum_distance = std::min(minimum_distance, distance);
             }
         }
+        return minimum_distance;
+    }
+
+    // bound every pair first, then run the DP on the most promising first, until the rest can't beat the best
+    std::vector<Phoneme_Profile> profiles2(pronunciations2.begin(), pronunciations2.end());
+    struct Bounded_Pair {
+        int bound;
+        std::size_t p1;
+        std::size_t p2;
+    };
+    std::vector<Bounded_Pair> pairs{};
+    pairs.reserve(pronunciations1.size() * pronunciations2.size());
+    for (std::size_t i{}; i < pronunciations1.size(); ++i) {
+        const Phoneme_Profile profile1{pronunciations1[i]};
+        for (std::size_t j{}; j < pronunciations2.size(); ++j) {
+            pairs.push_back(Bounded_Pair{levenshtein_lower_bound(profile1, profiles2[j]), i, j});
+        }
+    }
+    std::sort(pairs.begin(), pairs.end(), [](const Bounded_Pair& a, const Bounded_Pair& b) { return a.bound < b.bound; });
+
+    int minimum_distance{DISTANCE_OVER_BOUND};
+    for (const auto& [bound, p1, p2] : pairs) {
+        if (bound >= minimum_distance) {
+            break;
+        }
+        const int distance = minimum_distance == DISTANCE_OVER_BOUND ? levenshtein_distance(pronunciations1[p1], pronunciations2[p2])
+                                                                     : levenshtein_distance(pronunciations1[p1], pronunciations2[p2], minimum_distance - 1);
+        minimum_distance = std::min(minimum_distance, distance);
     }
 
     return minimum_distance;
 }
 
+std::vector<int> Rhyme_and_Meter::batch_rhyme_distance(std::span<const PhonemeId> query, std::span<const PhonemeSequence> candidates) {
+    return levenshtein_distance_batch(query, candidates);
+}
+
+namespace {
+    // Each word's pronunciations, interned
+    std::vector<std::vector<PhonemeSequence>> interned_word_pronunciations(const Phonetic::TextToPhonesResult& text_result) {
+        std::vector<std::vector<PhonemeSequence>> words{};
+        words.reserve(text_result.words_with_pronunciations.size());
+        for (const auto& [word, pronunciations] : text_result.words_with_pronunciations) {
+            auto& interned = words.emplace_back();
+            interned.reserve(pronunciations.size());
+            for (const auto& pronunciation : pronunciations) {
+                interned.emplace_back(phones_string_to_ids(pronunciation));
+            }
+        }
+        return words;
+    }
+}
+
 std::expected<std::vector<std::vector<std::string>>, Rhyme_and_Meter::UnidentifiedWords> 
 Rhyme_and_Meter::get_text_pronunciation_combinations(const std::string& text) {
     auto text_result = dict.text_to_phones(text);
@@ -494,54 +539,291 @@ Rhyme_and_Meter::get_text_pronunciation_combinations(const std::string& text) {
         return std::unexpected(UnidentifiedWords{text_result.failed_words});
     }
     
-    // Generate all possible pronunciation combinations
+    // Generate all possible pronunciation combinations, stepping through them with the same odometer the streaming comparisons use
     std::vector<std::vector<std::string>> combinations;
+    Pronunciation_Combinations odometer{interned_word_pronunciations(text_result)};
+    if (odometer.empty()) {
+        return combinations;
+    }
+    combinations.reserve(odometer.count());
+    do {
+        auto& combination = combinations.emplace_back();
+        combination.reserve(odometer.choices().size());
+        for (std::size_t word{}; word < odometer.choices().size(); ++word) {
+            combination.emplace_back(text_result.words_with_pronunciations[word].second[odometer.choices()[word]]);
+        }
+    } while (odometer.next());
+    return combinations;
+}
+
+std::expected<Pronunciation_Combinations, Rhyme_and_Meter::UnidentifiedWords> 
+Rhyme_and_Meter::stream_text_pronunciation_combinations(const std::string& text) {
+    auto text_result = dict.text_to_phones(text);
+    if (text_result.has_failures()) {
+        return std::unexpected(UnidentifiedWords{text_result.failed_words});
+    }
+    return Pronunciation_Combinations{interned_word_pronunciations(text_result)};
+}
+
+std::expected<std::pair<Pronunciation_Combinations, Pronunciation_Combinations>, Rhyme_and_Meter::UnidentifiedWords> 
+Rhyme_and_Meter::stream_texts_pronunciation_combinations(const std::string& text1, const std::string& text2) {
+    auto combinations1_result = stream_text_pronunciation_combinations(text1);
+    auto combinations2_result = stream_text_pronunciation_combinations(text2);
     
-    // Helper function to generate combinations recursively
-    std::function<void(size_t, std::vector<std::string>, const Phonetic::TextToPhonesResult&, std::vector<std::vector<std::string>>&)> generate_combinations = 
-        [&](size_t word_index, std::vector<std::string> current_combination, const Phonetic::TextToPhonesResult& text_result, std::vector<std::vector<std::string>>& all_combinations) {
-            if (word_index >= text_result.words_with_pronunciations.size()) {
-                all_combinations.emplace_back(current_combination);
-                return;
-            }
-            
-            const auto& pronunciations = text_result.words_with_pronunciations[word_index].second;
-            for (const auto& pronunciation : pronunciations) {
-                auto new_combination = current_combination;
-                new_combination.emplace_back(pronunciation);
-                generate_combinations(word_index + 1, new_combination, text_result, all_combinations);
-            }
-        };
+    // Check if either text has unidentified words and collect all of them
+    std::vector<std::string> all_failed_words;
+    if (!combinations1_result.has_value()) {
+        all_failed_words.insert(all_failed_words.end(), 
+            combinations1_result.error().words.begin(), 
+            combinations1_result.error().words.end());
+    }
+    if (!combinations2_result.has_value()) {
+        all_failed_words.insert(all_failed_words.end(), 
+            combinations2_result.error().words.begin(), 
+            combinations2_result.error().words.end());
+    }
     
-    generate_combinations(0, {}, text_result, combinations);
-    return combinations;
+    // If there are any failed words, return them all together
+    if (!all_failed_words.empty()) {
+        return std::unexpected(UnidentifiedWords{all_failed_words});
+    }
+    
+    return std::pair{std::move(combinations1_result.value()), std::move(combinations2_result.value())};
+}
+
+int Rhyme_and_Meter::pronunciation_distance(std::span<const PhonemeId> phones1, std::span<const PhonemeId> phones2, int max_distance) const {
+    // Document-length pairs are filled block by block across the threads, unbounded, see levenshtein_distance(..., pool)
+    if (alignment_pool && std::min(phones1.size(), phones2.size()) >= 2 * LEVENSHTEIN_TILE) {
+        const int distance = levenshtein_distance(phones1, phones2, *alignment_pool);
+        return distance > max_distance ? DISTANCE_OVER_BOUND : distance;
+    }
+    return max_distance < DISTANCE_OVER_BOUND ? levenshtein_distance(phones1, phones2, max_distance) : levenshtein_distance(phones1, phones2);
+}
+
+std::expected<Pronunciation_Lattice, Rhyme_and_Meter::UnidentifiedWords> 
+Rhyme_and_Meter::get_text_pronunciation_lattice(const std::string& text) {
+    auto text_result = dict.text_to_phones(text);
+    if (text_result.has_failures()) {
+        return std::unexpected(UnidentifiedWords{text_result.failed_words});
+    }
+
+    Pronunciation_Lattice lattice{};
+    for (const auto& pronunciations : interned_word_pronunciations(text_result)) {
+        lattice.add_word(pronunciations);
+    }
+    return lattice;
 }
 
 std::expected<int, Rhyme_and_Meter::UnidentifiedWords> 
 Rhyme_and_Meter::minimum_text_distance(const std::string& text1, const std::string& text2) {
-    return compare_text_pronunciations<int>(text1, text2, 
-        [](const std::vector<std::string>& phones1, const std::vector<std::string>& phones2) {
-            return levenshtein_distance(phones_vector_to_string(phones1), phones_vector_to_string(phones2));
-        },
-        [](const int& a, const int& b) { return a < b; });
+    auto lattice1 = get_text_pronunciation_lattice(text1);
+    auto lattice2 = get_text_pronunciation_lattice(text2);
+
+    // report the unidentified words of both texts together
+    std::vector<std::string> unidentified_words{};
+    for (const auto* lattice : {&lattice1, &lattice2}) {
+        if (!lattice->has_value()) {
+            unidentified_words.insert(unidentified_words.end(), lattice->error().words.begin(), lattice->error().words.end());
+        }
+    }
+    if (!unidentified_words.empty()) {
+        return std::unexpected(UnidentifiedWords{unidentified_words});
+    }
+
+    if (lattice1->single_path() && lattice2->single_path()) {
+        return pronunciation_distance(lattice1->phonemes().subspan(1), lattice2->phonemes().subspan(1), DISTANCE_OVER_BOUND);
+    }
+    return lattice_distance(lattice1.value(), lattice2.value());
 }
 
 std::expected<Alignment_And_Distance, Rhyme_and_Meter::UnidentifiedWords> 
 Rhyme_and_Meter::minimum_text_alignment(const std::string& text1, const std::string& text2) {
-    return compare_text_pronunciations<Alignment_And_Distance>(text1, text2, 
-        [](const std::vector<std::string>& phones1, const std::vector<std::string>& phones2) {
-            return hirschberg(phones1, phones2);
-        },
-        [](const Alignment_And_Distance& a, const Alignment_And_Distance& b) { return a.distance < b.distance; });
+    auto script = minimum_text_edit_script(text1, text2);
+    if (!script) {
+        return std::unexpected(script.error());
+    }
+    // only the winning alignment gets converted back to strings
+    return to_alignment_and_distance(script.value());
+}
+
+std::expected<Edit_Script_And_Distance, Rhyme_and_Meter::UnidentifiedWords> 
+Rhyme_and_Meter::minimum_text_edit_script(const std::string& text1, const std::string& text2) {
+    auto scripts = minimum_text_edit_scripts(text1, text2, 1);
+    if (!scripts) {
+        return std::unexpected(scripts.error());
+    }
+    return scripts->empty() ? Edit_Script_And_Distance{} : std::move(scripts->front());
+}
+
+std::expected<std::vector<Edit_Script_And_Distance>, Rhyme_and_Meter::UnidentifiedWords> 
+Rhyme_and_Meter::minimum_text_edit_scripts(const std::string& text1, const std::string& text2, std::size_t k) {
+    auto combinations = stream_texts_pronunciation_combinations(text1, text2);
+    if (!combinations) {
+        return std::unexpected(combinations.error());
+    }
+    auto& [combinations1, combinations2] = combinations.value();
+
+    // A pair is kept by its choice of pronunciation for each word, and rebuilt for its alignment
+    struct Scored_Pair {
+        int distance;
+        std::vector<std::size_t> choices1;
+        std::vector<std::size_t> choices2;
+    };
+
+    if (combinations1.empty() || combinations2.empty()) {
+        return std::vector<Edit_Script_And_Distance>{};
+    }
+
+    // Tracebacks are bounded by the distance their pair is already known to have
+    const auto edit_script = [this](const PhonemeSequence& phones1, const PhonemeSequence& phones2, int distance) {
+        const auto alignment = alignment_pool ? hirschberg(phones1, phones2, distance, *alignment_pool) : hirschberg(phones1, phones2, distance);
+        return to_edit_script(phones1, phones2, alignment);
+    };
+
+    // Only the best pair: by its lower bound first, or shared out across combination_pool, as compare_text_pronunciations() would
+    const std::size_t count1{combinations1.count()};
+    const std::size_t count2{combinations2.count()};
+    const auto at_least = [count1, count2](std::size_t pairs) { return count1 >= (pairs + count2 - 1) / count2; };
+    if (k == 1 && count2 < std::numeric_limits<std::uint32_t>::max() && at_least(LOWER_BOUND_PAIRS)) {
+        struct Pronunciation_Distance {
+            const Rhyme_and_Meter& rhyme_and_meter;
+            int operator()(const PhonemeSequence& phones1, const PhonemeSequence& phones2, const std::optional<int>& minimum) const {
+                return rhyme_and_meter.pronunciation_distance(phones1, phones2, minimum ? *minimum - 1 : DISTANCE_OVER_BOUND);
+            }
+            int lower_bound(const Phoneme_Profile& profile1, const Phoneme_Profile& profile2) const {
+                return levenshtein_lower_bound(profile1, profile2);
+            }
+        } comparison{*this};
+
+        const std::vector<PhonemeSequence> pronunciations2{all_pronunciations(combinations2)};
+        Task_Pool* pool{combination_pool && at_least(COMBINATION_PARALLEL_PAIRS) ? combination_pool.get() : nullptr};
+        const auto best = block_compare_pronunciations<int>(combinations1, pronunciations2, comparison, pool);
+        combinations1.seek(best.choices1);
+        return std::vector<Edit_Script_And_Distance>{edit_script(combinations1.current(), pronunciations2[best.pronunciation2], best.result)};
+    }
+
+    // Score-only pass: the k best pairs so far, closest first. Only pairs strictly better than the k-th can get in, so ties keep the earlier pair, and once the k-th is at distance 0 nothing can.
+    // Pairs whose lower bound is already over that skip the DP, see levenshtein_lower_bound().
+    std::vector<Scored_Pair> best{};
+    best.reserve(k + 1);
+    const auto settled = [&best, k] { return best.size() == k && best.back().distance == 0; };
+    if (k > 0) {
+        std::vector<Phoneme_Profile> profiles2{};
+        do {
+            profiles2.emplace_back(combinations2.current());
+        } while (combinations2.next());
+
+        do {
+            const Phoneme_Profile profile1{combinations1.current()};
+            std::size_t pronunciation2{};
+            combinations2.reset();
+            do {
+                const Phoneme_Profile& profile2{profiles2[pronunciation2++]};
+                const int max_distance = best.size() == k ? best.back().distance - 1 : DISTANCE_OVER_BOUND;
+                if (max_distance < DISTANCE_OVER_BOUND && levenshtein_lower_bound(profile1, profile2) > max_distance) {
+                    continue;
+                }
+                const int distance = pronunciation_distance(combinations1.current(), combinations2.current(), max_distance);
+                if (distance > max_distance) {
+                    continue;
+                }
+                const auto position = std::upper_bound(best.begin(), best.end(), distance,
+                    [](int d, const Scored_Pair& pair) { return d < pair.distance; });
+                best.insert(position, Scored_Pair{distance,
+                    {combinations1.choices().begin(), combinations1.choices().end()},
+                    {combinations2.choices().begin(), combinations2.choices().end()}});
+                if (best.size() > k) {
+                    best.pop_back();
+                }
+            } while (!settled() && combinations2.next());
+        } while (!settled() && combinations1.next());
+    }
+
+    // Tracebacks for the survivors only
+    std::vector<Edit_Script_And_Distance> scripts{};
+    scripts.reserve(best.size());
+    for (const auto& [distance, choices1, choices2] : best) {
+        combinations1.seek(choices1);
+        combinations2.seek(choices2);
+        scripts.emplace_back(edit_script(combinations1.current(), combinations2.current(), distance));
+    }
+    return scripts;
+}
+
+void Rhyme_and_Meter::set_alignment_threads(std::size_t threads) {
+    alignment_pool = threads > 1 ? std::make_unique<Task_Pool>(threads) : nullptr;
+}
+
+void Rhyme_and_Meter::set_combination_threads(std::size_t threads) {
+    combination_pool = threads > 1 ? std::make_unique<Task_Pool>(threads) : nullptr;
+}
+
+std::expected<std::vector<PhonemeSequence>, Rhyme_and_Meter::UnidentifiedWords> 
+Rhyme_and_Meter::get_line_end_pronunciations(const std::string& line) {
+    std::istringstream iss{line};
+    std::vector<std::string> words{std::istream_iterator<std::string>{iss}, std::istream_iterator<std::string>{}};
+    if (words.empty()) {
+        return std::unexpected(UnidentifiedWords{{""}});
+    }
+
+    // walk back from the last word until one is stressed however it's said, so the rhyme starts in the words we keep
+    std::vector<std::vector<std::string>> end_word_pronunciations{};
+    for (auto word = words.rbegin(); word != words.rend(); ++word) {
+        auto phones = dict.word_to_phones(*word);
+        if (!phones || phones->empty()) {
+            return std::unexpected(UnidentifiedWords{{phones ? *word : phones.error().unidentified_word}});
+        }
+        const bool always_stressed = std::all_of(phones->begin(), phones->end(), [](const std::string& pronunciation) {
+            return pronunciation.find('1') != std::string::npos;
+        });
+        end_word_pronunciations.emplace_back(std::move(phones.value()));
+        if (always_stressed) {
+            break;
+        }
+    }
+
+    // every combination, first word first
+    std::vector<PhonemeSequence> line_ends{PhonemeSequence{}};
+    for (auto pronunciations = end_word_pronunciations.rbegin(); pronunciations != end_word_pronunciations.rend(); ++pronunciations) {
+        std::vector<PhonemeSequence> longer{};
+        longer.reserve(line_ends.size() * pronunciations->size());
+        for (const auto& line_end : line_ends) {
+            for (const auto& pronunciation : *pronunciations) {
+                const PhonemeSequence word_ids{phones_string_to_ids(pronunciation)};
+                auto& combination = longer.emplace_back(line_end);
+                combination.insert(combination.end(), word_ids.begin(), word_ids.end());
+            }
+        }
+        line_ends = std::move(longer);
+    }
+    return line_ends;
 }
 
 std::expected<int, Rhyme_and_Meter::UnidentifiedWords> 
 Rhyme_and_Meter::get_end_rhyme_distance(const std::string& line1, const std::string& line2) {
-    auto rhyming_parts = compare_end_line_rhyming_parts(line1, line2);
-    if (!rhyming_parts) {
-        return std::unexpected(rhyming_parts.error());
+    auto line_ends1 = get_line_end_pronunciations(line1);
+    auto line_ends2 = get_line_end_pronunciations(line2);
+
+    // report the unidentified words of both lines together
+    std::vector<std::string> unidentified_words{};
+    for (const auto* line_ends : {&line_ends1, &line_ends2}) {
+        if (!line_ends->has_value()) {
+            unidentified_words.insert(unidentified_words.end(), line_ends->error().words.begin(), line_ends->error().words.end());
+        }
+    }
+    if (!unidentified_words.empty()) {
+        return std::unexpected(UnidentifiedWords{unidentified_words});
+    }
+
+    // only pairs closer than the best so far matter, the rest can give up early
+    int minimum_distance{DISTANCE_OVER_BOUND};
+    for (const auto& end1 : line_ends1.value()) {
+        for (const auto& end2 : line_ends2.value()) {
+            const int max_distance = minimum_distance == DISTANCE_OVER_BOUND ? DISTANCE_OVER_BOUND : minimum_distance - 1;
+            minimum_distance = std::min(minimum_distance, end_rhyme_distance(end1, end2, max_distance));
+        }
     }
-    return minimum_rhyme_distance(rhyming_parts.value());
+    return minimum_distance;
 }
 
 #ifdef __EMSCRIPTEN__
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "phoneme_id.hpp"
+#include <cstddef>
+#include <random>
+
+// A small alphabet for random_sequence(), with repeated consonants and stress variants so that cheap substitutions, exact matches and the repeated consonant discount all show up.
+inline const PhonemeSequence& repeated_consonant_alphabet() {
+    static const PhonemeSequence alphabet{phones_string_to_ids("K K T L L AH0 AH1 IY1 EH2 ER0 S Z")};
+    return alphabet;
+}
+
+/**
+ * A random phoneme sequence for the randomised tests.
+ * @param rng (std::mt19937&): the test's generator.
+ * @param alphabet (const PhonemeSequence&): the phonemes to draw from, uniformly. Repeat a phoneme to draw it more often.
+ * @param max_length (std::size_t): the longest sequence to return.
+ * @param min_length (std::size_t): the shortest sequence to return; pass max_length for a fixed length.
+ * @return (PhonemeSequence): a sequence of uniformly random length in [min_length, max_length].
+ */
+inline PhonemeSequence random_sequence(std::mt19937& rng, const PhonemeSequence& alphabet, std::size_t max_length, std::size_t min_length = 0) {
+    std::uniform_int_distribution<std::size_t> pick(0, alphabet.size() - 1);
+    std::uniform_int_distribution<std::size_t> length(min_length, max_length);
+    PhonemeSequence sequence(length(rng));
+    for (auto& p : sequence) p = alphabet[pick(rng)];
+    return sequence;
+}
@@ -2,6 +2,7 @@
 #include "convenience.hpp"
 #include <vector>
 #include <string>
+#include <string_view>
 
 TEST_CASE("convenience functions tests") {
 
@@ -92,4 +93,17 @@ TEST_CASE("convenience functions tests") {
         
         REQUIRE(string_result == original);
     }
+
+    SECTION("PhoneTokens views the original string") {
+        std::string phones = "\tK  EH2\nR ";
+        std::vector<std::string_view> tokens{};
+        for (std::string_view phone : PhoneTokens{phones}) {
+            tokens.emplace_back(phone);
+        }
+
+        REQUIRE(tokens == std::vector<std::string_view>{"K", "EH2", "R"});
+        REQUIRE(tokens[0].data() == phones.data() + 1);
+        REQUIRE(PhoneTokens{""}.begin() == PhoneTokens{""}.end());
+        REQUIRE(PhoneTokens{"   "}.begin() == PhoneTokens{"   "}.end());
+    }
 } 
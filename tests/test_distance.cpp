@@ -0,0 +1,431 @@
+#include <catch2/catch_test_macros.hpp>
+#include "distance.hpp"
+#include "distance_kernels.hpp"
+#include "Hirschberg.hpp"
+#include "levenshtein_distance.hpp"
+#include "phoneme_id.hpp"
+#include "task_pool.hpp"
+#include "random_sequence.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+    /**
+     * Cost of an alignment, column by column, checking that it aligns X with Y.
+     * @param ZWpair (const PhonemeAlignment&): aligned columns, gaps are PHONEME::GAP
+     * @param X (span<const PhonemeId>): the sequence in ZWpair.first
+     * @param Y (span<const PhonemeId>): the sequence in ZWpair.second
+     * @param gaps_x (span<const int>): penalty for leaving each phoneme of X unaligned
+     * @param gaps_y (span<const int>): penalty for leaving each phoneme of Y unaligned
+     * @return (int): the sum of the gap penalties and substitution scores of the columns
+     */
+    int checked_alignment_cost(const PhonemeAlignment& ZWpair, std::span<const PhonemeId> X, std::span<const PhonemeId> Y,
+                               std::span<const int> gaps_x, std::span<const int> gaps_y) {
+        REQUIRE(ZWpair.first.size() == ZWpair.second.size());
+        PhonemeSequence aligned_x{};
+        PhonemeSequence aligned_y{};
+        int cost{};
+        for (std::size_t k{}; k < ZWpair.first.size(); ++k) {
+            const PhonemeId x{ZWpair.first[k]};
+            const PhonemeId y{ZWpair.second[k]};
+            if (x == PHONEME::GAP) cost += gaps_y[aligned_y.size()];
+            else if (y == PHONEME::GAP) cost += gaps_x[aligned_x.size()];
+            else cost += SUBSTITUTION_SCORE(x, y);
+            if (x != PHONEME::GAP) aligned_x.push_back(x);
+            if (y != PHONEME::GAP) aligned_y.push_back(y);
+        }
+        REQUIRE(std::ranges::equal(aligned_x, X));
+        REQUIRE(std::ranges::equal(aligned_y, Y));
+        return cost;
+    }
+}
+
+TEST_CASE("distance tests") {
+
+    SECTION("PhonemeCostTable matches SUBSTITUTION_SCORE reference path") {
+        const PhonemeCostTable& costs{phoneme_cost_table()};
+        for (std::size_t i{}; i < PHONEME::COUNT; ++i) {
+            for (std::size_t j{}; j < PHONEME::COUNT; ++j) {
+                const auto id1{static_cast<PhonemeId>(i)};
+                const auto id2{static_cast<PhonemeId>(j)};
+                REQUIRE(costs.substitution_score(id1, id2) == SUBSTITUTION_SCORE(id_to_phoneme(id1), id_to_phoneme(id2)));
+                REQUIRE(SUBSTITUTION_SCORE(id1, id2) == SUBSTITUTION_SCORE(id_to_phoneme(id1), id_to_phoneme(id2)));
+            }
+        }
+    }
+
+    SECTION("PhonemeCostTable matches GAP_PENALTY reference path") {
+        const PhonemeCostTable& costs{phoneme_cost_table()};
+        for (std::size_t i{}; i < PHONEME::COUNT; ++i) {
+            const auto id{static_cast<PhonemeId>(i)};
+            REQUIRE(costs.gap_penalty(id) == GAP_PENALTY(id_to_phoneme(id)));
+            for (std::size_t j{}; j < PHONEME::COUNT; ++j) {
+                const auto prev{static_cast<PhonemeId>(j)};
+                REQUIRE(costs.gap_penalty(id, prev) == GAP_PENALTY(id_to_phoneme(id), id_to_phoneme(prev)));
+            }
+        }
+    }
+
+    SECTION("gap_penalties per position") {
+        auto phonemes{phones_string_to_ids("K K IH1 IH1 T")};
+        auto penalties{gap_penalties(phonemes)};
+        REQUIRE(penalties.size() == 5);
+        REQUIRE(penalties[0] == CONSTANTS::CONSONANT::INDEL_PENALTY);
+        REQUIRE(penalties[1] == CONSTANTS::CONSONANT::REPEATED_CONSONANT_PENALTY);
+        REQUIRE(penalties[2] == CONSTANTS::VOWEL::INDEL_PENALTY);
+        REQUIRE(penalties[3] == CONSTANTS::VOWEL::INDEL_PENALTY);
+        REQUIRE(penalties[4] == CONSTANTS::CONSONANT::INDEL_PENALTY);
+    }
+
+    SECTION("levenshtein_distance base cases sum the gap penalties") {
+        // Deleting a leading "AH0 AH0" costs two vowel gaps, however the row is reached.
+        REQUIRE(levenshtein_distance("AH0 AH0 K", "K") == CONSTANTS::VOWEL::INDEL_PENALTY * 2);
+        REQUIRE(levenshtein_distance("K", "AH0 AH0 K") == CONSTANTS::VOWEL::INDEL_PENALTY * 2);
+
+        // Empty sequences get the repeated consonant discount too.
+        REQUIRE(levenshtein_distance("", "L L") == CONSTANTS::CONSONANT::INDEL_PENALTY + CONSTANTS::CONSONANT::REPEATED_CONSONANT_PENALTY);
+        REQUIRE(levenshtein_distance("", "") == 0);
+    }
+
+    SECTION("bounded distances agree with the unbounded ones under the bound") {
+        const PhonemeSequence& alphabet{repeated_consonant_alphabet()};
+        std::mt19937 rng{99};
+
+        for (int trial{}; trial < 300; ++trial) {
+            const PhonemeSequence X{random_sequence(rng, alphabet, 40)};
+            const PhonemeSequence Y{random_sequence(rng, alphabet, 40)};
+            const int distance{levenshtein_distance(X, Y)};
+            const std::vector<int> last_row{NWScore(X, Y)};
+            const auto alignment{hirschberg(X, Y)};
+            const int alignment_distance{alignment.distance};
+
+            // Hirschberg is exact, and its alignment costs what it says
+            REQUIRE(alignment_distance == distance);
+            REQUIRE(checked_alignment_cost(alignment.ZWpair, X, Y, gap_penalties(X), gap_penalties(Y)) == distance);
+
+            for (const int max_distance : {-1, 0, distance - 1, distance, distance + 1, distance / 2, 1000}) {
+                REQUIRE(levenshtein_distance(X, Y, max_distance) == (distance <= max_distance ? distance : DISTANCE_OVER_BOUND));
+
+                const std::vector<int> bounded_row{NWScore(X, Y, max_distance)};
+                REQUIRE(bounded_row.size() == last_row.size());
+                for (std::size_t j{}; j < last_row.size(); ++j) {
+                    REQUIRE(bounded_row[j] == (last_row[j] <= max_distance ? last_row[j] : DISTANCE_OVER_BOUND));
+                }
+
+                const auto bounded_alignment{hirschberg(X, Y, max_distance)};
+                REQUIRE(bounded_alignment.distance == (alignment_distance <= max_distance ? alignment_distance : DISTANCE_OVER_BOUND));
+            }
+        }
+    }
+
+    SECTION("edit scripts expand back to the alignment and walk both sequences in order") {
+        const PhonemeSequence& alphabet{repeated_consonant_alphabet()};
+        std::mt19937 rng{8080};
+
+        for (int trial{}; trial < 300; ++trial) {
+            const PhonemeSequence X{random_sequence(rng, alphabet, 40)};
+            const PhonemeSequence Y{random_sequence(rng, alphabet, 40)};
+            const auto alignment{hirschberg(X, Y)};
+            const auto script{to_edit_script(X, Y, alignment)};
+            REQUIRE(script.distance == alignment.distance);
+            REQUIRE(to_phoneme_alignment(script) == alignment.ZWpair);
+
+            // Runs are never empty, never follow a run of the same kind, and start where the one before ended
+            std::size_t x{};
+            std::size_t y{};
+            for (std::size_t k{}; k < script.runs.size(); ++k) {
+                const EditRun& run{script.runs[k]};
+                REQUIRE(run.length > 0);
+                REQUIRE(run.x_begin == x);
+                REQUIRE(run.y_begin == y);
+                if (k > 0) REQUIRE(script.runs[k - 1].op != run.op);
+                for (std::uint32_t offset{}; offset < run.length; ++offset) {
+                    if (run.op == EditOp::Match) REQUIRE(X[x + offset] == Y[y + offset]);
+                    if (run.op == EditOp::Substitute) REQUIRE(X[x + offset] != Y[y + offset]);
+                }
+                if (run.op != EditOp::Insert) x += run.length;
+                if (run.op != EditOp::Delete) y += run.length;
+            }
+            REQUIRE(x == X.size());
+            REQUIRE(y == Y.size());
+        }
+    }
+
+    SECTION("banded distances and alignments") {
+        const PhonemeSequence& alphabet{repeated_consonant_alphabet()};
+        std::mt19937 rng{1357};
+        std::uniform_int_distribution<int> stretch(-3, 3);
+
+        for (int trial{}; trial < 300; ++trial) {
+            // About the same length, as lines usually are
+            const PhonemeSequence X{random_sequence(rng, alphabet, 30)};
+            const std::size_t length_y{static_cast<std::size_t>(std::max(0, static_cast<int>(X.size()) + stretch(rng)))};
+            const PhonemeSequence Y{random_sequence(rng, alphabet, length_y, length_y)};
+            const int distance{levenshtein_distance(X, Y)};
+            const auto gaps_x{gap_penalties(X)};
+            const auto gaps_y{gap_penalties(Y)};
+
+            for (const std::size_t band : {std::size_t{0}, std::size_t{1}, std::size_t{3}, std::size_t{8}, std::size_t{100}}) {
+                const Banded_Distance banded{levenshtein_distance_banded(X, Y, band)};
+                REQUIRE(banded.distance >= distance);
+                if (banded.optimal) REQUIRE(banded.distance == distance);
+                if (band >= X.size() + Y.size()) REQUIRE(banded.optimal);
+
+                // The alignment is as good as the banded distance, and costs what it says
+                const auto alignment{hirschberg_banded(X, Y, band)};
+                REQUIRE(alignment.distance == banded.distance);
+                REQUIRE(alignment.optimal == banded.optimal);
+                REQUIRE(checked_alignment_cost(alignment.ZWpair, X, Y, gaps_x, gaps_y) == alignment.distance);
+            }
+
+            // A band sized for a bound is exact for every distance within it
+            for (const int max_distance : {0, distance - 1, distance, distance + 7, 2 * distance}) {
+                const Banded_Distance banded{levenshtein_distance_banded(X, Y, band_for_max_distance(gaps_x, gaps_y, max_distance))};
+                if (distance <= max_distance) {
+                    REQUIRE(banded.distance == distance);
+                    REQUIRE(banded.optimal);
+                }
+                else {
+                    REQUIRE(banded.distance > max_distance);
+                }
+            }
+        }
+    }
+
+    SECTION("incremental distances as a sequence grows and shrinks") {
+        const PhonemeSequence& alphabet{repeated_consonant_alphabet()};
+        std::mt19937 rng{97531};
+        std::uniform_int_distribution<int> action(0, 3);
+        std::uniform_int_distribution<std::size_t> word_length(1, 6);
+
+        for (int trial{}; trial < 20; ++trial) {
+            const PhonemeSequence reference{random_sequence(rng, alphabet, 40)};
+            Incremental_Levenshtein comparator{reference};
+            REQUIRE(comparator.size() == 0);
+            REQUIRE(comparator.distance() == levenshtein_distance(PhonemeSequence{}, reference));
+
+            PhonemeSequence typed{};
+            for (int edit{}; edit < 30; ++edit) {
+                // mostly typing words, sometimes deleting some phonemes
+                if (action(rng) == 0) {
+                    const std::size_t count{word_length(rng)};
+                    comparator.pop_back(count);
+                    typed.resize(typed.size() - std::min(count, typed.size()));
+                }
+                else {
+                    const PhonemeSequence word{random_sequence(rng, alphabet, 6, 1)};
+                    comparator.append(word);
+                    typed.insert(typed.end(), word.begin(), word.end());
+                }
+                REQUIRE(std::equal(comparator.sequence().begin(), comparator.sequence().end(), typed.begin(), typed.end()));
+                REQUIRE(comparator.distance() == levenshtein_distance(typed, reference));
+                const std::vector<int> last_row{comparator.last_row().begin(), comparator.last_row().end()};
+                REQUIRE(last_row == NWScore(typed, reference));
+            }
+        }
+    }
+
+    SECTION("lower bounds never exceed the distance") {
+        // vowel to vowel substitutions as cheap as a stress change, and repeated consonants, so each bound is tested at its weakest
+        const PhonemeSequence alphabet{phones_string_to_ids("K K T D L L R AH0 AH1 IY1 IY0 EH2 ER0 S Z")};
+        std::mt19937 rng{24680};
+
+        for (int trial{}; trial < 2000; ++trial) {
+            const PhonemeSequence s1{random_sequence(rng, alphabet, 12)};
+            const PhonemeSequence s2{random_sequence(rng, alphabet, 12)};
+            const int bound{levenshtein_lower_bound(Phoneme_Profile{s1}, Phoneme_Profile{s2})};
+            REQUIRE(bound >= 0);
+            REQUIRE(bound <= levenshtein_distance(s1, s2));
+            REQUIRE(bound == levenshtein_lower_bound(Phoneme_Profile{s2}, Phoneme_Profile{s1}));
+        }
+
+        // identical sequences, in any order, bound nothing
+        REQUIRE(levenshtein_lower_bound(Phoneme_Profile{phones_string_to_ids("K AE1 T S")}, Phoneme_Profile{phones_string_to_ids("S T AE1 K")}) == 0);
+        // two more vowels and two more consonants
+        REQUIRE(levenshtein_lower_bound(Phoneme_Profile{phones_string_to_ids("K AE1 T")}, Phoneme_Profile{phones_string_to_ids("K AE1 T AH0 L AA1 G")})
+                >= 2 * CONSTANTS::VOWEL::INDEL_PENALTY + 2 * CONSTANTS::CONSONANT::INDEL_PENALTY);
+        // unrelated consonants can't be matched for less than their gap penalties
+        REQUIRE(levenshtein_lower_bound(Phoneme_Profile{phones_string_to_ids("AE1 K")}, Phoneme_Profile{phones_string_to_ids("AE1 M")}) > 0);
+    }
+
+    SECTION("end anchored rhyme distances and alignments") {
+        // P AH0 N EH1 L AH0 P IY0: the rhyme starts at the stressed EH1, and its last syllable at IY0
+        const PhonemeSequence penelope{phones_string_to_ids("P AH0 N EH1 L AH0 P IY0")};
+        REQUIRE(rhyme_start(penelope) == 3);
+        REQUIRE(rhyme_syllables(penelope) == 3);
+        REQUIRE(rhyme_tail_start(penelope, 1) == 7);
+        REQUIRE(rhyme_tail_start(penelope, 2) == 5);
+        REQUIRE(rhyme_tail_start(penelope, 5) == 3);
+        REQUIRE(rhyme_start(phones_string_to_ids("DH AH0")) == 1);
+        REQUIRE(rhyme_start(phones_string_to_ids("HH M")) == 0);
+
+        // leading material is free, and the rhymes are cut to the shorter one
+        REQUIRE(end_rhyme_distance(phones_string_to_ids("P UH1 L IY0"), phones_string_to_ids("B UH1 L IY0")) == 0);
+        REQUIRE(end_rhyme_distance(phones_string_to_ids("B L IY1 D"), penelope) ==
+                levenshtein_distance(phones_string_to_ids("IY1 D"), phones_string_to_ids("IY0")));
+
+        const PhonemeSequence alphabet{phones_string_to_ids("K T L S AH0 AH1 IY1 EH2 ER0 UW1")};
+        std::mt19937 rng{2468};
+
+        for (int trial{}; trial < 300; ++trial) {
+            const PhonemeSequence X{random_sequence(rng, alphabet, 20)};
+            const PhonemeSequence Y{random_sequence(rng, alphabet, 20)};
+            const int distance{end_rhyme_distance(X, Y)};
+
+            // never worse than cutting both rhymes out and aligning those, which is one of the alignments it considers
+            const std::size_t syllables{std::max<std::size_t>(1, std::min(rhyme_syllables(X), rhyme_syllables(Y)))};
+            const auto X_tail{std::span<const PhonemeId>{X}.subspan(rhyme_tail_start(X, syllables))};
+            const auto Y_tail{std::span<const PhonemeId>{Y}.subspan(rhyme_tail_start(Y, syllables))};
+            REQUIRE(distance <= levenshtein_distance(X_tail, Y_tail));
+
+            REQUIRE(end_rhyme_distance(X, Y, distance) == distance);
+            REQUIRE(end_rhyme_distance(X, Y, distance - 1) == DISTANCE_OVER_BOUND);
+
+            // the alignment covers both line ends and costs what it says
+            std::vector<int> gaps_x(X.size());
+            std::vector<int> gaps_y(Y.size());
+            end_rhyme_gap_penalties(X, Y, gaps_x, gaps_y);
+            const auto alignment{end_rhyme_alignment(X, Y)};
+            REQUIRE(alignment.distance == distance);
+            REQUIRE(checked_alignment_cost(alignment.ZWpair, X, Y, gaps_x, gaps_y) == distance);
+        }
+    }
+
+    SECTION("hirschberg on a pool matches it on one thread") {
+        const PhonemeSequence& alphabet{repeated_consonant_alphabet()};
+        std::mt19937 rng{4321};
+        Task_Pool pool{4};
+
+        for (int trial{}; trial < 10; ++trial) {
+            // long enough that the top few levels go over HIRSCHBERG_PARALLEL_CELLS
+            const PhonemeSequence X{random_sequence(rng, alphabet, 900, 200)};
+            const PhonemeSequence Y{random_sequence(rng, alphabet, 900, 200)};
+            const auto serial{hirschberg(X, Y)};
+            const auto parallel{hirschberg(X, Y, DISTANCE_OVER_BOUND, pool)};
+            REQUIRE(parallel.distance == serial.distance);
+            REQUIRE(parallel.ZWpair == serial.ZWpair);
+
+            REQUIRE(hirschberg(X, Y, serial.distance, pool).distance == serial.distance);
+            REQUIRE(hirschberg(X, Y, serial.distance - 1, pool).distance == DISTANCE_OVER_BOUND);
+            REQUIRE(hirschberg(X, Y, serial.distance - 1, pool).ZWpair.first.empty());
+        }
+    }
+
+    SECTION("blocked levenshtein on a pool matches the row by row fill") {
+        const PhonemeSequence& alphabet{repeated_consonant_alphabet()};
+        std::mt19937 rng{2468};
+        Task_Pool pool{3};
+
+        // Partial blocks at the ends, exact multiples of the block size, and too short to split, on either side
+        const std::vector<std::pair<std::size_t, std::size_t>> lengths{
+            {2 * LEVENSHTEIN_TILE + 37, 3 * LEVENSHTEIN_TILE + 501},
+            {3 * LEVENSHTEIN_TILE, 2 * LEVENSHTEIN_TILE},
+            {2 * LEVENSHTEIN_TILE + 1, 5 * LEVENSHTEIN_TILE - 1},
+            {LEVENSHTEIN_TILE, 3 * LEVENSHTEIN_TILE},
+        };
+        for (const auto& [length1, length2] : lengths) {
+            const PhonemeSequence X{random_sequence(rng, alphabet, length1, length1)};
+            const PhonemeSequence Y{random_sequence(rng, alphabet, length2, length2)};
+            std::vector<int> expected(Y.size() + 1);
+            levenshtein_last_row_scalar(X, Y, gap_penalties(X), gap_penalties(Y), phoneme_cost_table(), expected);
+
+            REQUIRE(levenshtein_distance(X, Y, pool) == expected.back());
+            REQUIRE(levenshtein_distance(Y, X, pool) == levenshtein_distance(Y, X));
+        }
+    }
+
+    SECTION("scores_fit") {
+        const int max_cost{phoneme_cost_table().max_cost};
+        REQUIRE(max_cost == CONSTANTS::VOWEL_TO_CONSONANT_MISMATCH);
+        REQUIRE(scores_fit<std::int16_t>(10, 10, max_cost));
+        REQUIRE(scores_fit<std::int16_t>(163, 163, max_cost));
+        REQUIRE_FALSE(scores_fit<std::int16_t>(164, 163, max_cost));
+        REQUIRE(scores_fit<std::int32_t>(164, 163, max_cost));
+    }
+
+    SECTION("kernel dispatch") {
+        REQUIRE(parse_kernel_isa("scalar") == KernelIsa::Scalar);
+        REQUIRE(parse_kernel_isa("avx2") == KernelIsa::AVX2);
+        REQUIRE(parse_kernel_isa("avx512") == KernelIsa::AVX512);
+        REQUIRE_FALSE(parse_kernel_isa("sse9").has_value());
+
+        REQUIRE(kernel_isa_available(KernelIsa::Scalar));
+        REQUIRE(kernel_isa_available(kernel_isa()));
+        REQUIRE(kernel_isa_available(kernel_isa(SIMD_MIN_LENGTH)));
+        REQUIRE(kernel_isa(AVX512_MIN_LENGTH) == kernel_isa());
+        // AVX-512 loses to AVX2 on short sequences, unless asked for
+        if (kernel_isa() == KernelIsa::AVX512 && kernel_isa_available(KernelIsa::AVX2) && !std::getenv("RHYME_AND_METER_ISA")) {
+            REQUIRE(kernel_isa(AVX512_MIN_LENGTH - 1) == KernelIsa::AVX2);
+        }
+        REQUIRE(last_row_kernel(KernelIsa::Scalar) == nullptr);
+        REQUIRE(block_kernel(KernelIsa::Scalar) == nullptr);
+        REQUIRE(batch_kernel(KernelIsa::Scalar) == nullptr);
+    }
+
+    SECTION("SIMD kernels match the scalar fill") {
+        const PhonemeSequence& alphabet{repeated_consonant_alphabet()};
+        const PhonemeCostTable& costs{phoneme_cost_table()};
+        std::mt19937 rng{1234};
+        const std::vector<KernelIsa> simd_isas{KernelIsa::AVX2, KernelIsa::AVX512};
+
+        for (int trial{}; trial < 200; ++trial) {
+            const PhonemeSequence X{random_sequence(rng, alphabet, 200, 1)};
+            const PhonemeSequence Y{random_sequence(rng, alphabet, 200, 1)};
+            const auto gaps_x{gap_penalties(X)};
+            const auto gaps_y{gap_penalties(Y)};
+            std::vector<int> expected(Y.size() + 1);
+            levenshtein_last_row_scalar(X, Y, gaps_x, gaps_y, costs, expected);
+
+            REQUIRE(levenshtein_distance(X, Y) == expected.back());
+            REQUIRE(NWScore(X, Y) == expected);
+            REQUIRE(NeedlemanWunsch(X, Y).distance == expected.back());
+            for (const KernelIsa isa : simd_isas) {
+                if (const LastRowKernel kernel{last_row_kernel(isa)}) {
+                    std::vector<int> last_row(Y.size() + 1, -1);
+                    kernel(X, Y, gaps_x, gaps_y, costs, last_row);
+                    REQUIRE(last_row == expected);
+                }
+            }
+
+            // Blocks start from arbitrary edges
+            std::uniform_int_distribution<int> edge_value(0, 2000);
+            std::vector<int> top(Y.size() + 1);
+            std::vector<int> left(X.size() + 1);
+            for (auto& cell : top) cell = edge_value(rng);
+            for (auto& cell : left) cell = edge_value(rng);
+            left[0] = top[0];
+            std::vector<int> expected_top{top};
+            std::vector<int> expected_left{left};
+            levenshtein_block_scalar(X, Y, gaps_x, gaps_y, costs, expected_top, expected_left);
+            for (const KernelIsa isa : simd_isas) {
+                if (const BlockKernel kernel{block_kernel(isa)}) {
+                    std::vector<int> block_top{top};
+                    std::vector<int> block_left{left};
+                    kernel(X, Y, gaps_x, gaps_y, costs, block_top, block_left);
+                    REQUIRE(block_top == expected_top);
+                    REQUIRE(block_left == expected_left);
+                }
+            }
+        }
+
+        // Batches with candidates of mixed lengths, including empty ones, across several groups of lanes, and with a few too long for 16 bit lanes
+        const PhonemeSequence query{random_sequence(rng, alphabet, 20)};
+        std::vector<PhonemeSequence> candidates(37);
+        for (auto& candidate : candidates) candidate = random_sequence(rng, alphabet, 20);
+        candidates[3].assign(400, alphabet[0]);
+        candidates[20].assign(350, alphabet[5]);
+        const auto distances{levenshtein_distance_batch(query, candidates)};
+        REQUIRE(distances.size() == candidates.size());
+        for (std::size_t k{}; k < candidates.size(); ++k) {
+            std::vector<int> last_row(candidates[k].size() + 1);
+            levenshtein_last_row_scalar(query, candidates[k], gap_penalties(query), gap_penalties(candidates[k]), costs, last_row);
+            REQUIRE(distances[k] == last_row.back());
+        }
+    }
+}
@@ -0,0 +1,50 @@
+#include <catch2/catch_test_macros.hpp>
+#include "phoneme_id.hpp"
+#include <string>
+#include <vector>
+
+TEST_CASE("phoneme_id tests") {
+
+    SECTION("phoneme_to_id and id_to_phoneme round trip every phoneme") {
+        for (std::size_t id{}; id < PHONEME::COUNT; ++id) {
+            std::string phoneme{id_to_phoneme(static_cast<PhonemeId>(id))};
+            REQUIRE(phoneme_to_id(phoneme) == id);
+        }
+    }
+
+    SECTION("vowels and stress") {
+        PhonemeId iy1{phoneme_to_id("IY1")};
+        PhonemeId iy0{phoneme_to_id("IY0")};
+        REQUIRE(is_vowel(iy1));
+        REQUIRE(is_vowel(iy0));
+        REQUIRE(vowel_index(iy1) == vowel_index(iy0));
+        REQUIRE(vowel_stress(iy1) == 1);
+        REQUIRE(vowel_stress(iy0) == 0);
+        REQUIRE(PHONEME::VOWEL_SYMBOLS[vowel_index(iy1)] == "IY");
+
+        REQUIRE(!is_vowel(phoneme_to_id("K")));
+        REQUIRE(!is_vowel(PHONEME::GAP));
+    }
+
+    SECTION("unknown phonemes throw") {
+        REQUIRE_THROWS(phoneme_to_id("QS"));
+        REQUIRE_THROWS(phoneme_to_id("IY"));
+        REQUIRE_THROWS(phoneme_to_id("IY3"));
+        REQUIRE_THROWS(phoneme_to_id(""));
+    }
+
+    SECTION("phones_string_to_ids and ids_to_phones") {
+        std::string phones = "  K EH2 R IY0   OW1 K IY0 ";
+        auto ids = phones_string_to_ids(phones);
+        REQUIRE(ids.size() == 7);
+        REQUIRE(ids[0] == ids[5]);
+        REQUIRE(ids_to_phones(ids) == std::vector<std::string>{"K", "EH2", "R", "IY0", "OW1", "K", "IY0"});
+        REQUIRE(phones_to_ids(ids_to_phones(ids)) == ids);
+
+        std::vector<std::string> words{"K EH2", "R IY0", "OW1 K IY0"};
+        REQUIRE(pronunciations_to_ids(words) == ids);
+
+        PhonemeSequence with_gap{ids[0], PHONEME::GAP};
+        REQUIRE(ids_to_phones(with_gap) == std::vector<std::string>{"K", "-"});
+    }
+}
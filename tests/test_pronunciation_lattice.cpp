@@ -0,0 +1,132 @@
+#include <catch2/catch_test_macros.hpp>
+#include "levenshtein_distance.hpp"
+#include "phoneme_id.hpp"
+#include "pronunciation_lattice.hpp"
+#include "random_sequence.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace {
+    // Every combination of one pronunciation per word, the way get_text_pronunciation_combinations() enumerates them
+    std::vector<PhonemeSequence> combinations(const std::vector<std::vector<PhonemeSequence>>& words) {
+        std::vector<PhonemeSequence> result{PhonemeSequence{}};
+        for (const auto& pronunciations : words) {
+            std::vector<PhonemeSequence> longer{};
+            for (const auto& prefix : result) {
+                for (const auto& pronunciation : pronunciations) {
+                    auto& combination = longer.emplace_back(prefix);
+                    combination.insert(combination.end(), pronunciation.begin(), pronunciation.end());
+                }
+            }
+            result = std::move(longer);
+        }
+        return result;
+    }
+
+    Pronunciation_Lattice lattice_of(const std::vector<std::vector<PhonemeSequence>>& words) {
+        Pronunciation_Lattice lattice{};
+        for (const auto& pronunciations : words) {
+            lattice.add_word(pronunciations);
+        }
+        return lattice;
+    }
+}
+
+TEST_CASE("Pronunciation_Combinations tests") {
+
+    SECTION("steps through every combination in order, and wraps around") {
+        const std::vector<std::vector<PhonemeSequence>> words{
+            {phones_string_to_ids("R EH1 D"), phones_string_to_ids("R IY1 D")},
+            {phones_string_to_ids("B UH1 K")},
+            {phones_string_to_ids("DH AH0"), phones_string_to_ids("DH AH1"), phones_string_to_ids("DH IY0")},
+        };
+        Pronunciation_Combinations odometer{words};
+        REQUIRE(odometer.count() == 6);
+
+        std::vector<PhonemeSequence> seen{};
+        std::vector<std::vector<std::size_t>> choices{};
+        do {
+            seen.emplace_back(odometer.current());
+            choices.emplace_back(odometer.choices().begin(), odometer.choices().end());
+        } while (odometer.next());
+        REQUIRE(seen == combinations(words));
+        REQUIRE(odometer.current() == seen.front());
+
+        // back to a combination by its choices
+        odometer.seek(choices[4]);
+        REQUIRE(odometer.current() == seen[4]);
+        REQUIRE(odometer.next());
+        REQUIRE(odometer.current() == seen[5]);
+        odometer.reset();
+        REQUIRE(odometer.current() == seen[0]);
+    }
+
+    SECTION("no words is one empty combination, a word without pronunciations none") {
+        Pronunciation_Combinations no_words{{}};
+        REQUIRE(no_words.count() == 1);
+        REQUIRE_FALSE(no_words.empty());
+        REQUIRE(no_words.current().empty());
+        REQUIRE_FALSE(no_words.next());
+
+        Pronunciation_Combinations unpronounceable{{{phones_string_to_ids("B UH1 K")}, {}}};
+        REQUIRE(unpronounceable.empty());
+        REQUIRE(unpronounceable.count() == 0);
+        REQUIRE_FALSE(unpronounceable.next());
+    }
+}
+
+TEST_CASE("Pronunciation_Lattice tests") {
+
+    SECTION("one node per phoneme of each distinct pronunciation") {
+        // READ: R EH1 D, R IY1 D; THE: DH AH0, DH AH1, DH IY0, and DH AH0 again
+        const std::vector<std::vector<PhonemeSequence>> words{
+            {phones_string_to_ids("R EH1 D"), phones_string_to_ids("R IY1 D")},
+            {phones_string_to_ids("DH AH0"), phones_string_to_ids("DH AH1"), phones_string_to_ids("DH IY0"), phones_string_to_ids("DH AH0")},
+        };
+        const Pronunciation_Lattice lattice{lattice_of(words)};
+        REQUIRE(lattice.size() == 1 + 6 + 6);
+        REQUIRE(lattice.paths() == 6);
+        REQUIRE(lattice.ends().size() == 3);
+        // the first phoneme of "the" follows either pronunciation of "read"
+        REQUIRE(lattice.predecessors(7).size() == 2);
+
+        const Pronunciation_Lattice empty{};
+        REQUIRE(empty.single_path());
+        REQUIRE(lattice_distance(empty, empty) == 0);
+        REQUIRE(lattice_distance(empty, lattice) == levenshtein_distance(PhonemeSequence{}, phones_string_to_ids("DH AH0")) + 
+                                                    std::min(levenshtein_distance(PhonemeSequence{}, phones_string_to_ids("R EH1 D")),
+                                                             levenshtein_distance(PhonemeSequence{}, phones_string_to_ids("R IY1 D"))));
+    }
+
+    SECTION("the same distance as the best pair of combinations") {
+        // repeated consonants, so the gap penalties across word boundaries depend on the pronunciation before
+        const PhonemeSequence& alphabet{repeated_consonant_alphabet()};
+        std::mt19937 rng{8642};
+        std::uniform_int_distribution<std::size_t> word_count(0, 4);
+        std::uniform_int_distribution<std::size_t> variant_count(1, 3);
+
+        const auto random_words = [&] {
+            std::vector<std::vector<PhonemeSequence>> words(word_count(rng));
+            for (auto& pronunciations : words) {
+                pronunciations.resize(variant_count(rng));
+                for (auto& pronunciation : pronunciations) pronunciation = random_sequence(rng, alphabet, 4);
+            }
+            return words;
+        };
+
+        for (int trial{}; trial < 300; ++trial) {
+            const auto words1{random_words()};
+            const auto words2{random_words()};
+            int expected{std::numeric_limits<int>::max()};
+            for (const auto& combination1 : combinations(words1)) {
+                for (const auto& combination2 : combinations(words2)) {
+                    expected = std::min(expected, levenshtein_distance(combination1, combination2));
+                }
+            }
+            REQUIRE(lattice_distance(lattice_of(words1), lattice_of(words2)) == expected);
+        }
+    }
+}
@@ -1,6 +1,8 @@
 #include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
 #include "distance.hpp"
 #include "levenshtein_distance.hpp"
+#include "random_sequence.hpp"
 #include "rhyme_and_meter.hpp"
 #include "vowel_hex_graph.hpp"
 #include <iostream>
@@ -8,6 +10,7 @@
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <random>
 
 struct Fixture {
     mutable Rhyme_and_Meter dict;
@@ -341,6 +344,13 @@ TEST_CASE_PERSISTENT_FIXTURE(Fixture, "Dictionary tests") {
         auto bleed_penelope = dict.minimum_rhyme_distance(rhyming_parts.value());
         REQUIRE(bleed_penelope == GAP_PENALTY() + SUBSTITUTION_SCORE("IY1", "IY0"));
 
+        // Already interned rhyming parts give the same distance
+        std::vector<PhonemeSequence> bleed_ids{};
+        std::vector<PhonemeSequence> penelope_ids{};
+        for (const auto& part : rhyming_parts->first) bleed_ids.emplace_back(phones_string_to_ids(part));
+        for (const auto& part : rhyming_parts->second) penelope_ids.emplace_back(phones_string_to_ids(part));
+        REQUIRE(dict.minimum_rhyme_distance(bleed_ids, penelope_ids) == bleed_penelope);
+
         // Vowel Distance + 1 Insertions
         // TODO check vowel stresses
         //   AO1 R    IH0 N JH
@@ -377,6 +387,48 @@ TEST_CASE_PERSISTENT_FIXTURE(Fixture, "Dictionary tests") {
         REQUIRE(rhyming_parts.has_value());
         auto uses_abuses = dict.minimum_rhyme_distance(rhyming_parts.value());
         REQUIRE(uses_abuses == 0);
+
+        // pairs skipped by their lower bounds never hide a closer one
+        const PhonemeSequence alphabet{phones_string_to_ids("K T L L R AH0 AH1 IY1 IY0 UW1 S Z")};
+        std::mt19937 rng{13579};
+        std::uniform_int_distribution<std::size_t> count(1, 5);
+        for (int trial{}; trial < 200; ++trial) {
+            std::vector<PhonemeSequence> parts1(count(rng));
+            std::vector<PhonemeSequence> parts2(count(rng));
+            for (auto* parts : {&parts1, &parts2}) {
+                for (auto& part : *parts) part = random_sequence(rng, alphabet, 6);
+            }
+            int expected{DISTANCE_OVER_BOUND};
+            for (const auto& p1 : parts1) {
+                for (const auto& p2 : parts2) {
+                    expected = std::min(expected, levenshtein_distance(p1, p2));
+                }
+            }
+            REQUIRE(dict.minimum_rhyme_distance(parts1, parts2) == expected);
+        }
+    }
+
+    SECTION("batch_rhyme_distance") {
+        auto query = phones_string_to_ids("UH1 L IY0");
+        std::vector<PhonemeSequence> candidates{};
+        for (const auto& candidate : {"UH1 L IY0", "IY0", "AO1 L T R IY0", "", "Y UW1 S IH0 Z", "AH0 B Y UW1 S IH0 Z",
+                                      "K K L L IY0", "UH1", "IH1 N JH", "AO1 R AH0 N JH", "P OW1 AH0 T"}) {
+            candidates.emplace_back(phones_string_to_ids(candidate));
+        }
+
+        auto distances = dict.batch_rhyme_distance(query, candidates);
+        REQUIRE(distances.size() == candidates.size());
+        REQUIRE(distances[0] == 0);
+        for (size_t k = 0; k < candidates.size(); ++k) {
+            REQUIRE(distances[k] == levenshtein_distance(query, candidates[k]));
+        }
+
+        // Empty query and no candidates
+        distances = dict.batch_rhyme_distance(PhonemeSequence{}, candidates);
+        for (size_t k = 0; k < candidates.size(); ++k) {
+            REQUIRE(distances[k] == levenshtein_distance(PhonemeSequence{}, candidates[k]));
+        }
+        REQUIRE(dict.batch_rhyme_distance(query, std::vector<PhonemeSequence>{}).empty());
     }
 
     SECTION("hirschberg") {
@@ -472,12 +524,47 @@ TEST_CASE_PERSISTENT_FIXTURE(Fixture, "Dictionary tests") {
         REQUIRE(multiple_repetition_distance == CONSTANTS::CONSONANT::REPEATED_CONSONANT_PENALTY * 2);
     }
 
+    SECTION("hirschberg alignment keeps every phoneme") {
+        // Recursion bottoms out in empty halves here, which must still emit their phonemes against gaps.
+        std::vector<std::string> phones1 = {"SH", "DH"};
+        std::vector<std::string> phones2 = {"NG", "AW1", "M"};
+        auto alignment = hirschberg(phones1, phones2);
+        REQUIRE(alignment.ZWpair.first.size() == alignment.ZWpair.second.size());
+
+        std::vector<std::string> first_without_gaps{};
+        std::vector<std::string> second_without_gaps{};
+        for (const auto& phone : alignment.ZWpair.first) {
+            if (phone != "-") first_without_gaps.emplace_back(phone);
+        }
+        for (const auto& phone : alignment.ZWpair.second) {
+            if (phone != "-") second_without_gaps.emplace_back(phone);
+        }
+        REQUIRE(first_without_gaps == phones1);
+        REQUIRE(second_without_gaps == phones2);
+    }
+
     SECTION("get_end_rhyme_distance") {
         std::string pulley = "I pulled the pulley";
         std::string bully = "which summoned by bully";
         auto pulley_bully = dict.get_end_rhyme_distance(pulley, bully);
         REQUIRE(pulley_bully.has_value());
         REQUIRE(pulley_bully.value() == 0);
+
+        // the same as cutting out the rhyming parts first, when the words before them can't help
+        std::string bleed = "do you bleed";
+        std::string penelope = "Penelope";
+        auto bleed_penelope = dict.get_end_rhyme_distance(bleed, penelope);
+        REQUIRE(bleed_penelope.has_value());
+        REQUIRE(bleed_penelope.value() == dict.minimum_rhyme_distance(dict.compare_end_line_rhyming_parts(bleed, penelope).value()));
+
+        // an unstressed last word takes the rhyme back into the word before it
+        // AH1 V DH AH0
+        auto line_ends = dict.get_line_end_pronunciations("so many of the");
+        REQUIRE(line_ends.has_value());
+        REQUIRE(line_ends.value().size() == 3);
+        REQUIRE(std::find(line_ends.value().begin(), line_ends.value().end(), phones_string_to_ids("AH1 V DH AH0")) != line_ends.value().end());
+        REQUIRE(end_rhyme_distance(phones_string_to_ids("AH1 V DH AH0"), phones_string_to_ids("B L AH1 D DH AH0")) ==
+                levenshtein_distance(phones_string_to_ids("AH1 V DH AH0"), phones_string_to_ids("AH1 D DH AH0")));
     }
 
     SECTION("get_end_rhyme_distance error cases") {
@@ -541,6 +628,97 @@ TEST_CASE_PERSISTENT_FIXTURE(Fixture, "Dictionary tests") {
         REQUIRE(alignment.distance > 0);
     }
 
+    SECTION("minimum_text_edit_script") {
+        auto script_result = dict.minimum_text_edit_script("read book", "write story");
+        auto alignment_result = dict.minimum_text_alignment("read book", "write story");
+        REQUIRE(script_result.has_value());
+        REQUIRE(alignment_result.has_value());
+
+        const auto& script = script_result.value();
+        REQUIRE(script.distance == alignment_result.value().distance);
+        REQUIRE(to_alignment_and_distance(script).ZWpair == alignment_result.value().ZWpair);
+
+        // identical texts are a single run of matches
+        auto same = dict.minimum_text_edit_script("read book", "read book");
+        REQUIRE(same.has_value());
+        REQUIRE(same.value().runs == std::vector<EditRun>{EditRun{0, 0, static_cast<std::uint32_t>(same.value().X.size()), EditOp::Match}});
+
+        REQUIRE_FALSE(dict.minimum_text_edit_script("read xyzzy", "book").has_value());
+
+        // spreading alignments over threads doesn't change them
+        dict.set_alignment_threads(3);
+        auto threaded = dict.minimum_text_edit_script("read book", "write story");
+        dict.set_alignment_threads(1);
+        REQUIRE(threaded.has_value());
+        REQUIRE(threaded.value().runs == script.runs);
+        REQUIRE(threaded.value().distance == script.distance);
+    }
+
+    SECTION("minimum_text_edit_scripts") {
+        // "read" has two pronunciations, so "read book" against "read" is four pairs
+        auto scripts_result = dict.minimum_text_edit_scripts("read book", "read", 10);
+        REQUIRE(scripts_result.has_value());
+        const auto& scripts = scripts_result.value();
+        REQUIRE(scripts.size() == 4);
+        REQUIRE(std::is_sorted(scripts.begin(), scripts.end(), [](const auto& a, const auto& b) { return a.distance < b.distance; }));
+
+        // the first is the minimum, and every one is a real alignment of its pair at its distance
+        auto minimum = dict.minimum_text_edit_script("read book", "read");
+        REQUIRE(minimum.has_value());
+        REQUIRE(scripts.front().runs == minimum.value().runs);
+        REQUIRE(scripts.front().distance == dict.minimum_text_distance("read book", "read").value());
+        for (const auto& script : scripts) {
+            REQUIRE(script.distance == levenshtein_distance(script.X, script.Y));
+            const auto alignment = to_phoneme_alignment(script);
+            REQUIRE(alignment.first.size() == alignment.second.size());
+        }
+
+        auto top_two = dict.minimum_text_edit_scripts("read book", "read", 2);
+        REQUIRE(top_two.has_value());
+        REQUIRE(top_two.value().size() == 2);
+        REQUIRE(top_two.value()[0].distance == scripts[0].distance);
+        REQUIRE(top_two.value()[1].distance == scripts[1].distance);
+
+        // pairs skipped by their lower bounds never push out a closer one
+        auto combinations1 = dict.stream_text_pronunciation_combinations("read the book").value();
+        auto combinations2 = dict.stream_text_pronunciation_combinations("live a story").value();
+        std::vector<int> every_distance{};
+        do {
+            combinations2.reset();
+            do {
+                every_distance.push_back(levenshtein_distance(combinations1.current(), combinations2.current()));
+            } while (combinations2.next());
+        } while (combinations1.next());
+        std::sort(every_distance.begin(), every_distance.end());
+        auto top_three = dict.minimum_text_edit_scripts("read the book", "live a story", 3);
+        REQUIRE(top_three.has_value());
+        REQUIRE(top_three.value().size() == 3);
+        for (std::size_t i{}; i < 3; ++i) {
+            REQUIRE(top_three.value()[i].distance == every_distance[i]);
+        }
+
+        // the best pair alone is found by its lower bounds, or across threads, and it is the one the top k find first
+        for (const auto& [text1, text2] : {std::pair{"read the book", "live a story"}, std::pair{"read the read the read the", "a the"}, std::pair{"the the the", "the the"}}) {
+            auto top_two_pairs = dict.minimum_text_edit_scripts(text1, text2, 2);
+            auto best_pair = dict.minimum_text_edit_script(text1, text2);
+            dict.set_combination_threads(4);
+            auto threaded_pair = dict.minimum_text_edit_script(text1, text2);
+            dict.set_combination_threads(1);
+            REQUIRE(best_pair.value().distance == top_two_pairs.value().front().distance);
+            REQUIRE(best_pair.value().runs == top_two_pairs.value().front().runs);
+            REQUIRE(to_phoneme_alignment(best_pair.value()) == to_phoneme_alignment(top_two_pairs.value().front()));
+            REQUIRE(to_phoneme_alignment(threaded_pair.value()) == to_phoneme_alignment(best_pair.value()));
+        }
+
+        // k pairs at distance 0 end the search
+        auto exact = dict.minimum_text_edit_scripts("the the", "the the", 2);
+        REQUIRE(exact.value().size() == 2);
+        REQUIRE(exact.value().back().distance == 0);
+
+        REQUIRE(dict.minimum_text_edit_scripts("read book", "read", 0).value().empty());
+        REQUIRE_FALSE(dict.minimum_text_edit_scripts("read xyzzy", "book", 3).has_value());
+    }
+
     SECTION("minimum_text_alignment error handling") {
         // Test with text containing unrecognized words
         std::string text1 = "read xyzzy";
@@ -576,6 +754,87 @@ TEST_CASE_PERSISTENT_FIXTURE(Fixture, "Dictionary tests") {
         distance_result = dict.minimum_text_distance(text3, text4);
         REQUIRE(distance_result.has_value());
         REQUIRE(distance_result.value() > 0);  // Different words should have distance > 0
+
+        // Texts with several pronunciations go through the lattice, and agree with comparing every pair of combinations
+        for (const auto& [text5, text6] : {std::pair{"read the book", "live a story"}, std::pair{"a read", "the"}, std::pair{"", "read the"}}) {
+            auto every_pair = dict.compare_text_pronunciations<int>(text5, text6,
+                [](const PhonemeSequence& p1, const PhonemeSequence& p2, const std::optional<int>&) { return levenshtein_distance(p1, p2); },
+                [](const int& a, const int& b) { return a < b; });
+            REQUIRE(every_pair.has_value());
+            REQUIRE(dict.minimum_text_distance(text5, text6).value() == every_pair.value());
+
+            // distance results rank themselves, with or without a bound
+            auto bounded = dict.compare_text_pronunciations<int>(text5, text6,
+                [](const PhonemeSequence& p1, const PhonemeSequence& p2, const std::optional<int>& minimum) {
+                    return minimum ? levenshtein_distance(p1, p2, *minimum - 1) : levenshtein_distance(p1, p2);
+                });
+            REQUIRE(bounded.value() == every_pair.value());
+
+            auto alignment = dict.compare_text_pronunciations<Phoneme_Alignment_And_Distance>(text5, text6,
+                [](const PhonemeSequence& p1, const PhonemeSequence& p2, const std::optional<Phoneme_Alignment_And_Distance>&) { return hirschberg(p1, p2); });
+            REQUIRE(alignment.value().distance == every_pair.value());
+        }
+
+        // a custom min_func sees every pair, here to find the furthest one
+        int comparisons{};
+        auto furthest = dict.compare_text_pronunciations<int>("read the", "a",
+            [&comparisons](const PhonemeSequence& p1, const PhonemeSequence& p2, const std::optional<int>&) { ++comparisons; return levenshtein_distance(p1, p2); },
+            [](const int& a, const int& b) { return a > b; });
+        REQUIRE(comparisons == 2 * 3 * 2);
+        REQUIRE(furthest.value() > dict.minimum_text_distance("read the", "a").value());
+
+        // by distance, a perfect match ends the search
+        comparisons = 0;
+        auto identical = dict.compare_text_pronunciations<int>("read", "read",
+            [&comparisons](const PhonemeSequence& p1, const PhonemeSequence& p2, const std::optional<int>&) { ++comparisons; return levenshtein_distance(p1, p2); });
+        REQUIRE(identical.value() == 0);
+        REQUIRE(comparisons == 1);
+
+        // 36 * 6 pairs, enough to share out across threads, with the same winner among ties as one thread finds
+        const auto bounded_alignment = [](const PhonemeSequence& p1, const PhonemeSequence& p2, const std::optional<Phoneme_Alignment_And_Distance>& minimum) {
+            return minimum ? hirschberg(p1, p2, minimum->distance - 1) : hirschberg(p1, p2);
+        };
+        const auto bounded_distance = [](const PhonemeSequence& p1, const PhonemeSequence& p2, const std::optional<int>& minimum) {
+            return minimum ? levenshtein_distance(p1, p2, *minimum - 1) : levenshtein_distance(p1, p2);
+        };
+        for (const auto& [text7, text8] : {std::pair{"read the read the", "a the"}, std::pair{"the a the a", "the read"}, std::pair{"the the the", "the the"}}) {
+            auto serial_alignment = dict.compare_text_pronunciations<Phoneme_Alignment_And_Distance>(text7, text8, bounded_alignment);
+            auto serial_distance = dict.compare_text_pronunciations<int>(text7, text8, bounded_distance);
+            dict.set_combination_threads(4);
+            auto threaded_alignment = dict.compare_text_pronunciations<Phoneme_Alignment_And_Distance>(text7, text8, bounded_alignment);
+            auto threaded_distance = dict.compare_text_pronunciations<int>(text7, text8, bounded_distance);
+            dict.set_combination_threads(1);
+            REQUIRE(threaded_distance.value() == serial_distance.value());
+            REQUIRE(threaded_alignment.value().distance == serial_alignment.value().distance);
+            REQUIRE(threaded_alignment.value().ZWpair == serial_alignment.value().ZWpair);
+        }
+
+        // pairs compared in ascending order of their lower bounds, with or without threads, find what comparing every pair in order finds
+        struct Bounded_Alignment {
+            Phoneme_Alignment_And_Distance operator()(const PhonemeSequence& p1, const PhonemeSequence& p2, const std::optional<Phoneme_Alignment_And_Distance>& minimum) const {
+                return minimum ? hirschberg(p1, p2, minimum->distance - 1) : hirschberg(p1, p2);
+            }
+            int lower_bound(const Phoneme_Profile& profile1, const Phoneme_Profile& profile2) const {
+                return levenshtein_lower_bound(profile1, profile2);
+            }
+        };
+        // 1296 * 6 pairs is several blocks of COMBINATION_BLOCK_PAIRS
+        for (const auto& [text9, text10] : {std::pair{"read the read the", "a the"}, std::pair{"read the book", "live a story"}, std::pair{"the the", "a"}, std::pair{"read", "book"},
+                                            std::pair{"read the read the read the read the", "a the"}}) {
+            auto serial_alignment = dict.compare_text_pronunciations<Phoneme_Alignment_And_Distance>(text9, text10, bounded_alignment);
+            auto serial_distance = dict.compare_text_pronunciations<int>(text9, text10, bounded_distance);
+            auto lower_bounded_alignment = dict.compare_text_pronunciations<Phoneme_Alignment_And_Distance>(text9, text10, Bounded_Alignment{});
+            REQUIRE(dict.compare_text_pronunciations<int>(text9, text10, Levenshtein_Comparison{}).value() == serial_distance.value());
+            REQUIRE(lower_bounded_alignment.value().distance == serial_alignment.value().distance);
+            REQUIRE(lower_bounded_alignment.value().ZWpair == serial_alignment.value().ZWpair);
+
+            dict.set_combination_threads(4);
+            auto threaded_alignment = dict.compare_text_pronunciations<Phoneme_Alignment_And_Distance>(text9, text10, Bounded_Alignment{});
+            auto threaded_distance = dict.compare_text_pronunciations<int>(text9, text10, Levenshtein_Comparison{});
+            dict.set_combination_threads(1);
+            REQUIRE(threaded_distance.value() == serial_distance.value());
+            REQUIRE(threaded_alignment.value().ZWpair == serial_alignment.value().ZWpair);
+        }
     }
 
     // Commenting this out because I think this is not the best place to handle calibration
@@ -608,3 +867,31 @@ TEST_CASE_PERSISTENT_FIXTURE(Fixture, "Dictionary tests") {
     //     REQUIRE(tree_tray.value() > tree_treat.value());
     // }
 }
+
+TEST_CASE_PERSISTENT_FIXTURE(Fixture, "batch_rhyme_distance benchmark", "[.][benchmark]") {
+    // Random rhyming parts of 1 to 12 phonemes, roughly what rhyme suggestions compare.
+    const PhonemeSequence alphabet{phones_string_to_ids("K T L N R S Z D AH0 AH1 IY0 IY1 UH1 AO1 EH1 AY1 ER0")};
+    std::mt19937 rng{42};
+
+    std::vector<PhonemeSequence> candidates(5000);
+    std::vector<std::string> candidate_strings{};
+    for (auto& candidate : candidates) {
+        candidate = random_sequence(rng, alphabet, 12, 1);
+        candidate_strings.emplace_back(phones_vector_to_string(ids_to_phones(candidate)));
+    }
+    const std::string query_string{"UH1 L IY0"};
+    const PhonemeSequence query{phones_string_to_ids(query_string)};
+
+    BENCHMARK("minimum_rhyme_distance loop") {
+        std::vector<int> distances{};
+        distances.reserve(candidate_strings.size());
+        for (const auto& candidate : candidate_strings) {
+            distances.emplace_back(dict.minimum_rhyme_distance({{query_string}, {candidate}}));
+        }
+        return distances;
+    };
+
+    BENCHMARK("batch_rhyme_distance") {
+        return dict.batch_rhyme_distance(query, candidates);
+    };
+}
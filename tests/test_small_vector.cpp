@@ -0,0 +1,77 @@
+#include <catch2/catch_test_macros.hpp>
+#include "small_vector.hpp"
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+TEST_CASE("SmallVector tests") {
+
+    SECTION("stays inline up to its capacity") {
+        SmallVector<int, 4> v{};
+        for (int i{}; i < 4; ++i) {
+            v.push_back(i);
+        }
+        REQUIRE(v.is_inline());
+        REQUIRE(v.size() == 4);
+
+        v.push_back(4);
+        REQUIRE_FALSE(v.is_inline());
+        REQUIRE(v.capacity() >= 5);
+        REQUIRE(std::vector<int>(v.begin(), v.end()) == std::vector<int>{0, 1, 2, 3, 4});
+    }
+
+    SECTION("converts to span") {
+        const SmallVector<int, 4> v{1, 2, 3};
+        std::span<const int> view{v};
+        REQUIRE(view.size() == 3);
+        REQUIRE(view.data() == v.data());
+    }
+
+    SECTION("insert, resize and assign") {
+        SmallVector<int, 4> v{2, 3};
+        v.insert(v.begin(), 1);
+        const std::vector<int> tail{4, 5, 6};
+        v.insert(v.end(), tail.begin(), tail.end());
+        REQUIRE(v == SmallVector<int, 4>{1, 2, 3, 4, 5, 6});
+
+        v.resize(2);
+        REQUIRE(v == SmallVector<int, 4>{1, 2});
+        v.resize(4, 7);
+        REQUIRE(v == SmallVector<int, 4>{1, 2, 7, 7});
+        v.assign(3, 0);
+        REQUIRE(v == SmallVector<int, 4>{0, 0, 0});
+        REQUIRE(SmallVector<int, 4>{1, 2} < SmallVector<int, 4>{1, 3});
+        REQUIRE_THROWS(v.at(3));
+    }
+
+    SECTION("push_back of its own element while growing") {
+        SmallVector<std::string, 2> v{"long enough to be on the heap itself", "b"};
+        v.push_back(v[0]);
+        REQUIRE(v.size() == 3);
+        REQUIRE(v[2] == v[0]);
+    }
+
+    SECTION("copies and moves, inline and spilled") {
+        for (const std::size_t count : {std::size_t{2}, std::size_t{10}}) {
+            SmallVector<std::string, 4> original{};
+            for (std::size_t i{}; i < count; ++i) {
+                original.emplace_back(std::to_string(i) + " long enough to be on the heap itself");
+            }
+
+            SmallVector<std::string, 4> copy{original};
+            REQUIRE(copy == original);
+
+            SmallVector<std::string, 4> moved{std::move(copy)};
+            REQUIRE(moved == original);
+            REQUIRE(copy.empty());
+
+            SmallVector<std::string, 4> assigned{"x"};
+            assigned = std::move(moved);
+            REQUIRE(assigned == original);
+            REQUIRE(moved.empty());
+            moved = assigned;
+            REQUIRE(moved == original);
+        }
+    }
+}
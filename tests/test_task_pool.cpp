@@ -0,0 +1,67 @@
+#include <catch2/catch_test_macros.hpp>
+#include "task_pool.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+    // Sums values[begin, end) by splitting it in halves, the way hirschberg() splits its alignments
+    long long split_sum(Task_Pool& pool, const std::vector<int>& values, std::size_t begin, std::size_t end) {
+        if (end - begin <= 8) {
+            return std::accumulate(values.begin() + begin, values.begin() + end, 0LL);
+        }
+        const std::size_t mid = begin + (end - begin) / 2;
+        long long left{};
+        long long right{};
+        pool.fork_join([&] { left = split_sum(pool, values, begin, mid); },
+                       [&] { right = split_sum(pool, values, mid, end); });
+        return left + right;
+    }
+}
+
+TEST_CASE("Task_Pool tests") {
+
+    SECTION("fork_join runs both sides, nested, on any number of threads") {
+        std::vector<int> values(5000);
+        std::iota(values.begin(), values.end(), -1000);
+        const long long expected{std::accumulate(values.begin(), values.end(), 0LL)};
+
+        for (const std::size_t threads : {std::size_t{0}, std::size_t{1}, std::size_t{2}, std::size_t{4}}) {
+            Task_Pool pool{threads};
+            REQUIRE(pool.size() == (threads > 1 ? threads : 1));
+            for (int repeat{}; repeat < 20; ++repeat) {
+                REQUIRE(split_sum(pool, values, 0, values.size()) == expected);
+            }
+        }
+    }
+
+    SECTION("parallel_for visits every index once") {
+        Task_Pool pool{4};
+        std::vector<int> visits(1000, 0);
+        pool.parallel_for(0, visits.size(), [&](std::size_t k) { ++visits[k]; });
+        REQUIRE(std::count(visits.begin(), visits.end(), 1) == 1000);
+        pool.parallel_for(5, 5, [&](std::size_t k) { ++visits[k]; });
+        REQUIRE(std::count(visits.begin(), visits.end(), 1) == 1000);
+    }
+
+    SECTION("exceptions come back to the caller after both sides finish") {
+        Task_Pool pool{3};
+        bool left_ran{};
+        bool right_ran{};
+        REQUIRE_THROWS_AS(pool.fork_join([&] { left_ran = true; },
+                                         [&] { right_ran = true; throw std::runtime_error("right"); }),
+                          std::runtime_error);
+        REQUIRE(left_ran);
+        REQUIRE(right_ran);
+
+        REQUIRE_THROWS_AS(pool.fork_join([] { throw std::out_of_range("left"); }, [] {}), std::out_of_range);
+
+        // and the pool still works afterwards
+        int sum{};
+        int other{};
+        pool.fork_join([&] { sum = 1; }, [&] { other = 2; });
+        REQUIRE(sum + other == 3);
+    }
+}
@@ -4,15 +4,9 @@
 #include <vector>
 #include <algorithm>
 
-struct VowelFixture {
-    VowelFixture() {
-        VowelHexGraph::initialize();
-    }
-};
-
-TEST_CASE_PERSISTENT_FIXTURE(VowelFixture, "VowelHexGraph tests") {
+TEST_CASE("VowelHexGraph tests") {
 
-    SECTION("VowelHexGraph initialize and add_edge working correctly") {
+    SECTION("VowelHexGraph edges working correctly") {
         std::vector<std::string> vowel_connections{VowelHexGraph::get_connected_vowels("AE")};
         std::vector<std::string> expected{"AA", "EH", "AH"};
         bool all_match{true};
@@ -33,6 +27,26 @@ TEST_CASE_PERSISTENT_FIXTURE(VowelFixture, "VowelHexGraph tests") {
         REQUIRE(VowelHexGraph::calculate_shortest_distance("AO", "IY") == 3);
     }
 
+    SECTION("VowelHexGraph distances are calculated at compile time") {
+        STATIC_REQUIRE(VowelHexGraph::get_distance("AE", "AH") == 1);
+        STATIC_REQUIRE(VowelHexGraph::get_distance("AO", "IY") == 3);
+        STATIC_REQUIRE(VowelHexGraph::get_distance(VowelHexGraph::get_vowel_id("UW"), VowelHexGraph::get_vowel_id("IH")) == 2);
+    }
+
+    SECTION("VowelHexGraph every vowel is connected and distances are symmetric") {
+        for (std::size_t i{}; i < PHONEME::VOWEL_COUNT; ++i) {
+            for (std::size_t j{}; j < PHONEME::VOWEL_COUNT; ++j) {
+                REQUIRE(VowelHexGraph::get_distance(i, j) >= 0);
+                REQUIRE(VowelHexGraph::get_distance(i, j) == VowelHexGraph::get_distance(j, i));
+                REQUIRE(VowelHexGraph::get_distance(i, j) == VowelHexGraph::calculate_shortest_distance(i, j));
+            }
+        }
+    }
+
+    SECTION("VowelHexGraph unknown vowel throws") {
+        REQUIRE_THROWS(VowelHexGraph::get_distance("QS", "AE"));
+    }
+
     SECTION("VowelHexGraph::calculate_all_distances") {
         REQUIRE(VowelHexGraph::get_distance("AE", "AE") == 0);
         REQUIRE(VowelHexGraph::get_distance("AE", "AH") == 1);